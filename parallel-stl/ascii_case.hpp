@@ -0,0 +1,132 @@
+#pragma once
+
+#include "intrinsics.hpp"
+
+#include <algorithm>
+#include <boost/algorithm/string.hpp>
+#include <boost/range/iterator_range.hpp>
+#include <cstddef>
+#include <execution>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#include <immintrin.h>
+#define PSTL_HAS_SSE2 1
+#endif
+
+namespace ascii_case_detail
+{
+    // Kernels lowercase [first, last) into dest (dest may equal first) and return false
+    // if any byte outside of ASCII has been seen
+    using Kernel = bool (*)(const char *first, const char *last, char *dest);
+
+    inline bool to_lower_scalar(const char *first, const char *last, char *dest)
+    {
+        unsigned char seen = 0;
+        for (; first != last; ++first, ++dest)
+        {
+            auto c = static_cast<unsigned char>(*first);
+            seen |= c;
+            *dest = static_cast<char>(c + (static_cast<unsigned char>(c - 'A') < 26 ? 'a' - 'A' : 0));
+        }
+        return (seen & 0x80) == 0;
+    }
+
+#ifdef PSTL_HAS_SSE2
+    inline bool to_lower_sse2(const char *first, const char *last, char *dest)
+    {
+        const __m128i before_a = _mm_set1_epi8('A' - 1);
+        const __m128i after_z = _mm_set1_epi8('Z' + 1);
+        const __m128i case_bit = _mm_set1_epi8('a' - 'A');
+        int seen = 0;
+
+        for (; last - first >= 16; first += 16, dest += 16)
+        {
+            __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first));
+            seen |= _mm_movemask_epi8(chars);
+            __m128i is_upper = _mm_and_si128(_mm_cmpgt_epi8(chars, before_a), _mm_cmplt_epi8(chars, after_z));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest), _mm_add_epi8(chars, _mm_and_si128(is_upper, case_bit)));
+        }
+
+        return to_lower_scalar(first, last, dest) && seen == 0;
+    }
+#endif
+
+#ifdef PSTL_HAS_AVX2_DISPATCH
+    __attribute__((target("avx2"))) inline bool to_lower_avx2(const char *first, const char *last, char *dest)
+    {
+        const __m256i before_a = _mm256_set1_epi8('A' - 1);
+        const __m256i after_z = _mm256_set1_epi8('Z' + 1);
+        const __m256i case_bit = _mm256_set1_epi8('a' - 'A');
+        int seen = 0;
+
+        for (; last - first >= 32; first += 32, dest += 32)
+        {
+            __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(first));
+            seen |= _mm256_movemask_epi8(chars);
+            __m256i is_upper = _mm256_and_si256(_mm256_cmpgt_epi8(chars, before_a), _mm256_cmpgt_epi8(after_z, chars));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest), _mm256_add_epi8(chars, _mm256_and_si256(is_upper, case_bit)));
+        }
+
+        return to_lower_sse2(first, last, dest) && seen == 0;
+    }
+#endif
+
+    inline Kernel select_kernel()
+    {
+#ifdef PSTL_HAS_AVX2_DISPATCH
+        if (__builtin_cpu_supports("avx2"))
+            return to_lower_avx2;
+#endif
+#ifdef PSTL_HAS_SSE2
+        return to_lower_sse2;
+#else
+        return to_lower_scalar;
+#endif
+    }
+} // namespace ascii_case_detail
+
+// Lowercases ASCII letters of [first, last) into dest with the widest vector unit of the CPU.
+// Returns false when a non-ASCII byte has been seen - the output should not be used then.
+inline bool to_lower_ascii(const char *first, const char *last, char *dest)
+{
+    static const ascii_case_detail::Kernel kernel = ascii_case_detail::select_kernel();
+    return kernel(first, last, dest);
+}
+
+inline bool to_lower_ascii(char *first, char *last)
+{
+    return to_lower_ascii(first, last, first);
+}
+
+// Same result as boost::to_lower for locales that map ASCII letters like the classic one;
+// the locale-aware path runs only for text with non-ASCII bytes
+template <typename Range>
+void to_lower_fast(Range &text)
+{
+    if (!to_lower_ascii(text.data(), text.data() + text.size()))
+        boost::to_lower(text);
+}
+
+// to_lower_fast over chunks of text with the policy - a non-ASCII byte sends only its own chunk
+// through the locale-aware path
+template <typename ExecutionPolicy, typename Range,
+    typename = std::enable_if_t<std::is_execution_policy_v<std::decay_t<ExecutionPolicy>>>>
+void to_lower_fast(ExecutionPolicy &&policy, Range &text, size_t chunk_size = 64 * 1024)
+{
+    chunk_size = std::max<size_t>(chunk_size, 1);
+    std::vector<size_t> chunks((text.size() + chunk_size - 1) / chunk_size);
+    std::iota(chunks.begin(), chunks.end(), size_t{0});
+
+    std::for_each(policy, chunks.begin(), chunks.end(), [&](size_t chunk) {
+        char *first = text.data() + chunk * chunk_size;
+        char *last = text.data() + std::min(text.size(), (chunk + 1) * chunk_size);
+        if (!to_lower_ascii(first, last))
+        {
+            auto chunk_text = boost::make_iterator_range(first, last);
+            boost::to_lower(chunk_text);
+        }
+    });
+}
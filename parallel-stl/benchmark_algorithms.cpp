@@ -1,16 +1,56 @@
 #define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "ascii_case.hpp"
+#include "benchmark_options.hpp"
+#include "benchmark_registry.hpp"
+#include "case_folding.hpp"
 #include "catch.hpp"
+#include "compaction.hpp"
+#include "concurrent_dedup.hpp"
+#include "external_sort.hpp"
+#include "fast_hash.hpp"
+#include "heavy_hitters.hpp"
+#include "inverted_index.hpp"
+#include "mapped_document.hpp"
+#include "measurement.hpp"
+#include "miller_rabin.hpp"
+#include "per_thread.hpp"
+#include "pmr_document.hpp"
+#include "pool_algorithms.hpp"
+#include "prime_sieve.hpp"
+#include "scaling.hpp"
+#include "stable_partition.hpp"
+#include "string_pool.hpp"
+#include "string_sort.hpp"
+#include "tracing.hpp"
+#include "word_frequency.hpp"
+#include "word_pipeline.hpp"
+#include "zipf_corpus.hpp"
 
 #include <algorithm>
+#include <array>
 #include <boost/algorithm/string.hpp>
+#include <chrono>
 #include <cmath>
+#include <cstdio>
 #include <execution>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
 #include <optional>
 #include <random>
 #include <string>
+#include <system_error>
 #include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 using DocumentContent = std::vector<std::string>;
 
@@ -31,7 +71,91 @@ std::optional<DocumentContent> load_words(const std::string &file_name)
     return words;
 }
 
-inline const DocumentContent words = [] { DocumentContent words = load_words("tokens.txt").value(); words.resize(words.size() / 10);  return words; }();
+// PSTL_CORPUS_WORDS=n replaces tokens.txt by n words of a synthetic Zipf corpus
+inline const DocumentContent words = [] {
+    if (const BenchmarkOptions &options = benchmark_options(); options.corpus_words > 0)
+        return ZipfCorpus{options.corpus}.generate_words(std::execution::par, options.corpus_words);
+
+    const auto document = load_words_mapped(std::execution::par, "tokens.txt").value();
+    return DocumentContent(document.begin(), document.begin() + document.size() / 10);
+}();
+
+inline const PooledDocumentContent pooled_words{words.begin(), words.end()};
+
+// The first size items, repeated as often as needed - the values keep their range at every size.
+// At their own size the items themselves are returned, without a copy.
+template <typename Container>
+std::shared_ptr<const Container> repeated(const Container &items, size_t size)
+{
+    if (size == items.size())
+        return std::shared_ptr<const Container>{std::shared_ptr<const Container>{}, &items};
+
+    auto sized_items = std::make_shared<Container>(size);
+    for (size_t i = 0; i < size; ++i)
+        (*sized_items)[i] = items[i % items.size()];
+    return sized_items;
+}
+
+std::shared_ptr<const DocumentContent> words_of_size(size_t size)
+{
+    return repeated(words, size);
+}
+
+PooledDocumentContent pooled_words_of_size(size_t size)
+{
+    const auto sized_words = words_of_size(size);
+    return {sized_words->begin(), sized_words->end()};
+}
+
+// A file of size words, one per line, removed with the last reference to its name. The latest
+// file is kept, so all samples of a benchmark read the same one.
+std::shared_ptr<const std::string> words_file_of_size(size_t size)
+{
+    static std::shared_ptr<const std::string> file_name;
+    static size_t file_size = 0;
+
+    if (file_name && file_size == size)
+        return file_name;
+
+    file_name.reset();
+    const auto path = std::filesystem::temp_directory_path() / ("pstl-words-" + std::to_string(std::random_device{}()) + ".txt");
+    {
+        std::ofstream output_file{path, std::ios::binary};
+        for (size_t i = 0; i < size; ++i)
+            output_file << words[i % words.size()] << '\n';
+    }
+
+    file_name.reset(new std::string{path.string()}, [](const std::string *name) {
+        std::remove(name->c_str());
+        delete name;
+    });
+    file_size = size;
+    return file_name;
+}
+
+// default_pool() or pinned_pool() - in the scaling sweep a pool with a worker per swept thread,
+// so the pool cases scale like the others
+WorkStealingPool &benchmark_pool(Affinity affinity = Affinity::none)
+{
+    const auto threads = ThreadLimit::active();
+    if (!threads)
+        return affinity == Affinity::pinned ? pinned_pool() : default_pool();
+
+    static std::map<std::pair<size_t, Affinity>, std::unique_ptr<WorkStealingPool>> pools;
+    auto &pool = pools[{*threads, affinity}];
+    if (!pool)
+        pool = std::make_unique<WorkStealingPool>(*threads, affinity);
+    return *pool;
+}
+
+// The stages of the pipeline share the swept threads in the scaling sweep
+WordPipelineSettings benchmark_pipeline_settings()
+{
+    WordPipelineSettings settings;
+    if (const auto threads = ThreadLimit::active())
+        settings.normalize_threads = settings.sort_threads = std::max<size_t>(*threads / 2, 1);
+    return settings;
+}
 
 TEST_CASE("hardware concurrency")
 {
@@ -39,76 +163,689 @@ TEST_CASE("hardware concurrency")
     std::cout << "No of words: " << words.size() << std::endl;
 }
 
+const BenchmarkGroup load_words_benchmarks{"load words", {
+    {"ifstream >> std::string", [](size_t size) {
+         return [file_name = words_file_of_size(size)] { return load_words(*file_name)->size(); };
+     }},
+    {"mmap + std::string_view", [](size_t size) {
+         return [file_name = words_file_of_size(size)] { return load_words_mapped(*file_name)->size(); };
+     }},
+    {"mmap + std::string_view - parallel tokenizer", [](size_t size) {
+         return [file_name = words_file_of_size(size)] { return load_words_mapped(std::execution::par, *file_name)->size(); };
+     }},
+}};
+
+TEST_CASE("load words")
+{
+    auto mapped_words = load_words_mapped("tokens.txt");
+    REQUIRE(mapped_words.has_value());
+
+    const DocumentContent loaded_words = load_words("tokens.txt").value();
+    REQUIRE(std::equal(loaded_words.begin(), loaded_words.end(), mapped_words->begin(), mapped_words->end()));
+
+    load_words_benchmarks.run(loaded_words.size());
+}
+
+const auto calc_std_hash = [](const auto &item) { return std::hash<std::remove_cv_t<std::remove_reference_t<decltype(item)>>>{}(item); };
+
+// Every word updates the sum of its thread - the cases are always counted: the packed slots
+// share cache lines and show it in the L1D misses, the padded ones do not
+template <typename Sums>
+unsigned long long accumulate_per_thread(Sums &sums, const DocumentContent &words_to_hash)
+{
+    std::for_each(std::execution::par, words_to_hash.begin(), words_to_hash.end(), [&](const auto &word) { sums.local() += calc_std_hash(word); });
+    return sums.combine(0ULL, std::plus{});
+}
+
+const BenchmarkGroup accumulate_benchmarks{"accumulate", {
+    {"std::accumulate", [](size_t size) {
+         return [sized_words = words_of_size(size)] {
+             return std::accumulate(sized_words->begin(), sized_words->end(), 0ULL, [](const auto &total, const auto &word) { return total + calc_std_hash(word); });
+         };
+     }},
+    {"std::transform_reduce - parallel", [](size_t size) {
+         return [sized_words = words_of_size(size)] { return std::transform_reduce(std::execution::par, sized_words->begin(), sized_words->end(), 0ULL, std::plus{}, calc_std_hash); };
+     }},
+    {"std::transform_reduce - parallel unsequenced", [](size_t size) {
+         return [sized_words = words_of_size(size)] { return std::transform_reduce(std::execution::par_unseq, sized_words->begin(), sized_words->end(), 0ULL, std::plus{}, calc_std_hash); };
+     }},
+    {"pstl::transform_reduce - work stealing pool", [](size_t size) {
+         return [policy = pstl::PoolPolicy{benchmark_pool()}, sized_words = words_of_size(size)] {
+             return pstl::transform_reduce(policy, sized_words->begin(), sized_words->end(), 0ULL, std::plus{}, calc_std_hash);
+         };
+     }},
+    BenchmarkCase{"per_thread sums - padded", [](size_t size) {
+         return [sized_words = words_of_size(size)] {
+             PerThread<unsigned long long> sums;
+             return accumulate_per_thread(sums, *sized_words);
+         };
+     }}.with_counters(),
+    BenchmarkCase{"per_thread sums - packed", [](size_t size) {
+         return [sized_words = words_of_size(size)] {
+             PerThread<unsigned long long, alignof(unsigned long long)> sums;
+             return accumulate_per_thread(sums, *sized_words);
+         };
+     }}.with_counters(),
+    {"std::accumulate - pooled", [](size_t size) {
+         return [sized_words = pooled_words_of_size(size)] {
+             return std::accumulate(sized_words.begin(), sized_words.end(), 0ULL, [](const auto &total, const auto &word) { return total + calc_std_hash(word); });
+         };
+     }},
+    {"std::transform_reduce - parallel - pooled", [](size_t size) {
+         return [sized_words = pooled_words_of_size(size)] {
+             return std::transform_reduce(std::execution::par, sized_words.begin(), sized_words.end(), 0ULL, std::plus{}, calc_std_hash);
+         };
+     }},
+}};
+
 TEST_CASE("accumulate")
 {
-    auto calc_hash = [](const auto &item) { return std::hash<std::remove_cv_t<std::remove_reference_t<decltype(item)>>>{}(item); };
+    REQUIRE(std::accumulate(pooled_words.begin(), pooled_words.end(), 0ULL, [](const auto &total, const auto &word) { return total + calc_std_hash(word); })
+        == std::accumulate(words.begin(), words.end(), 0ULL, [](const auto &total, const auto &word) { return total + calc_std_hash(word); }));
 
-    BENCHMARK("std::accumulate")
-    {
-        return std::accumulate(words.begin(), words.end(), 0ULL, [=](const auto &total, const auto &word) { return total + calc_hash(word);; });
-    };
+    accumulate_benchmarks.run(words.size());
+}
+
+const auto calc_fast_hash = [](const auto &item) { return fast_hash(std::string_view(item)); };
+
+// Sums the hashes of blocks of 1024 words, hashed by the batched hasher
+class BlockHasher
+{
+public:
+    static constexpr size_t block_size = 1024;
 
-    BENCHMARK("std::transform_reduce - parallel")
+    explicit BlockHasher(std::shared_ptr<const DocumentContent> words_to_hash)
+        : words_{std::move(words_to_hash)}, blocks_((words_->size() + block_size - 1) / block_size)
     {
-        return std::transform_reduce(std::execution::par, words.begin(), words.end(), 0ULL, std::plus{}, calc_hash);
-    };
+        std::iota(blocks_.begin(), blocks_.end(), 0);
+    }
 
-    BENCHMARK("std::transform_reduce - parallel unsequenced")
+    template <typename ExecutionPolicy>
+    unsigned long long sum(ExecutionPolicy &&policy) const
     {
-        return std::transform_reduce(std::execution::par, words.begin(), words.end(), 0ULL, std::plus{}, calc_hash);
-    };
+        return std::transform_reduce(policy, blocks_.begin(), blocks_.end(), 0ULL, std::plus{}, [this](size_t block) {
+            std::array<uint64_t, block_size> hashes;
+            auto first = words_->begin() + block * block_size;
+            auto last = words_->begin() + std::min(words_->size(), (block + 1) * block_size);
+            auto hashes_end = fast_hash(first, last, hashes.begin());
+            return std::accumulate(hashes.begin(), hashes_end, 0ULL);
+        });
+    }
+
+private:
+    std::shared_ptr<const DocumentContent> words_;
+    std::vector<size_t> blocks_;
+};
+
+const BenchmarkGroup accumulate_fast_hash_benchmarks{"accumulate - fast hash", {
+    {"std::accumulate", [](size_t size) {
+         return [sized_words = words_of_size(size)] {
+             return std::accumulate(sized_words->begin(), sized_words->end(), 0ULL, [](const auto &total, const auto &word) { return total + calc_fast_hash(word); });
+         };
+     }},
+    {"batched", [](size_t size) {
+         return [hasher = BlockHasher{words_of_size(size)}] { return hasher.sum(std::execution::seq); };
+     }},
+    {"std::transform_reduce - parallel", [](size_t size) {
+         return [sized_words = words_of_size(size)] { return std::transform_reduce(std::execution::par, sized_words->begin(), sized_words->end(), 0ULL, std::plus{}, calc_fast_hash); };
+     }},
+    {"std::transform_reduce - parallel unsequenced", [](size_t size) {
+         return [sized_words = words_of_size(size)] { return std::transform_reduce(std::execution::par_unseq, sized_words->begin(), sized_words->end(), 0ULL, std::plus{}, calc_fast_hash); };
+     }},
+    {"batched - parallel", [](size_t size) {
+         return [hasher = BlockHasher{words_of_size(size)}] { return hasher.sum(std::execution::par); };
+     }},
+    {"std::transform_reduce - parallel unsequenced - pooled", [](size_t size) {
+         return [sized_words = pooled_words_of_size(size)] {
+             return std::transform_reduce(std::execution::par_unseq, sized_words.begin(), sized_words.end(), 0ULL, std::plus{}, calc_fast_hash);
+         };
+     }},
+}};
+
+TEST_CASE("accumulate - fast hash")
+{
+    const auto expected = std::accumulate(words.begin(), words.end(), 0ULL, [](const auto &total, const auto &word) { return total + calc_fast_hash(word); });
+    REQUIRE(BlockHasher{words_of_size(words.size())}.sum(std::execution::seq) == expected);
+
+    accumulate_fast_hash_benchmarks.run(words.size());
 }
 
+const auto case_insensitive_less = [](const auto &a, const auto &b) { return boost::to_lower_copy(a) < boost::to_lower_copy(b); };
+
+const BenchmarkGroup sort_benchmarks{"sort", {
+    {"sequenced", [](size_t size) {
+         return [words_to_sort = *words_of_size(size)]() mutable {
+             std::sort(words_to_sort.begin(), words_to_sort.end(), case_insensitive_less);
+             return words_to_sort.front();
+         };
+     }},
+    {"parallel", [](size_t size) {
+         return [words_to_sort = *words_of_size(size)]() mutable {
+             std::sort(std::execution::par, words_to_sort.begin(), words_to_sort.end(), case_insensitive_less);
+             return words_to_sort.front();
+         };
+     }},
+    {"parallel - work stealing pool", [](size_t size) {
+         return [policy = pstl::PoolPolicy{benchmark_pool()}, words_to_sort = *words_of_size(size)]() mutable {
+             pstl::sort(policy, words_to_sort.begin(), words_to_sort.end(), case_insensitive_less);
+             return words_to_sort.front();
+         };
+     }},
+    {"parallel unsequenced", [](size_t size) {
+         return [words_to_sort = *words_of_size(size)]() mutable {
+             std::for_each(std::execution::par, words_to_sort.begin(), words_to_sort.end(), [](auto &w) { boost::to_lower(w); });
+             std::vector<std::string_view> words_views(words_to_sort.size());
+             std::transform(std::execution::par, words_to_sort.begin(), words_to_sort.end(), words_views.begin(), [](const auto &w) { return std::string_view(w); });
+
+             std::sort(std::execution::par_unseq, words_views.begin(), words_views.end());
+             return std::string(words_views.front());
+         };
+     }},
+    {"parallel unsequenced - ascii lowercase", [](size_t size) {
+         return [words_to_sort = *words_of_size(size)]() mutable {
+             std::for_each(std::execution::par, words_to_sort.begin(), words_to_sort.end(), [](auto &w) { to_lower_fast(w); });
+             std::vector<std::string_view> words_views(words_to_sort.size());
+             std::transform(std::execution::par, words_to_sort.begin(), words_to_sort.end(), words_views.begin(), [](const auto &w) { return std::string_view(w); });
+
+             std::sort(std::execution::par_unseq, words_views.begin(), words_views.end());
+             return std::string(words_views.front());
+         };
+     }},
+    {"parallel unsequenced - pooled - ascii lowercase", [](size_t size) {
+         return [words_to_sort = pooled_words_of_size(size)]() mutable {
+             to_lower_fast(std::execution::par, words_to_sort.arena());
+             words_to_sort.sort(std::execution::par_unseq);
+             return std::string(words_to_sort[0]);
+         };
+     }},
+    {"sequenced - folded keys", [](size_t size) {
+         return [words_to_sort = *words_of_size(size)]() mutable {
+             sort_case_insensitive(std::execution::seq, words_to_sort);
+             return words_to_sort.front();
+         };
+     }},
+    {"parallel - folded keys", [](size_t size) {
+         return [words_to_sort = *words_of_size(size)]() mutable {
+             sort_case_insensitive(std::execution::par, words_to_sort);
+             return words_to_sort.front();
+         };
+     }},
+    {"sequenced - msd radix", [](size_t size) {
+         return [words_to_sort = *words_of_size(size)]() mutable {
+             msd_sort(std::execution::seq, words_to_sort, CaseMode::insensitive);
+             return words_to_sort.front();
+         };
+     }},
+    {"parallel - msd radix", [](size_t size) {
+         return [words_to_sort = *words_of_size(size)]() mutable {
+             msd_sort(std::execution::par, words_to_sort, CaseMode::insensitive);
+             return words_to_sort.front();
+         };
+     }},
+    {"parallel - msd radix - string_view", [](size_t size) {
+         const auto sized_words = words_of_size(size);
+         return [sized_words, words_to_sort = std::vector<std::string_view>(sized_words->begin(), sized_words->end())]() mutable {
+             msd_sort(std::execution::par, words_to_sort, CaseMode::insensitive);
+             return words_to_sort.front();
+         };
+     }},
+}};
+
 TEST_CASE("sort")
 {
-    BENCHMARK_ADVANCED("sequenced")
-    (Catch::Benchmark::Chronometer meter)
+    REQUIRE_FALSE(std::is_sorted(words.begin(), words.end()));
+
+    sort_benchmarks.run(words.size());
+}
+
+const BenchmarkGroup sort_memory_layout_benchmarks{"sort - memory layout", {
+    {"std::vector<std::string> - sequenced", [](size_t size) {
+         return [words_to_sort = *words_of_size(size)]() mutable {
+             std::sort(words_to_sort.begin(), words_to_sort.end());
+             return words_to_sort.front();
+         };
+     }},
+    {"pooled - sequenced", [](size_t size) {
+         return [words_to_sort = pooled_words_of_size(size)]() mutable {
+             words_to_sort.sort(std::execution::seq);
+             return words_to_sort[0];
+         };
+     }},
+    {"std::vector<std::string> - parallel", [](size_t size) {
+         return [words_to_sort = *words_of_size(size)]() mutable {
+             std::sort(std::execution::par, words_to_sort.begin(), words_to_sort.end());
+             return words_to_sort.front();
+         };
+     }},
+    {"pooled - parallel", [](size_t size) {
+         return [words_to_sort = pooled_words_of_size(size)]() mutable {
+             words_to_sort.sort(std::execution::par);
+             return words_to_sort[0];
+         };
+     }},
+}};
+
+TEST_CASE("sort - memory layout")
+{
+    sort_memory_layout_benchmarks.run(words.size());
+}
+
+// Copies the words into the arena and releases them again
+size_t copy_and_reset(DocumentArena &arena, const DocumentContent &words_to_copy)
+{
+    size_t size = 0;
     {
-        auto words_to_sort = words;
-        REQUIRE_FALSE(std::is_sorted(words_to_sort.begin(), words_to_sort.end()));
+        const auto copy = arena.copy(words_to_copy.begin(), words_to_copy.end());
+        size = copy.size();
+    }
+    arena.reset();
+    return size;
+}
 
-        meter.measure([&] {
-            std::sort(
-                words_to_sort.begin(), words_to_sort.end(),
-                [](const auto &a, const auto &b) { return boost::to_lower_copy(a) < boost::to_lower_copy(b); });
-            return words_to_sort.front();
-        });
-    };
+// A copy of the words in an arena for every run - the copies are destroyed before their arena
+struct ArenaCopies
+{
+    ArenaCopies(ArenaKind kind, const DocumentContent &words_to_copy, int runs)
+        : arena{kind}
+    {
+        for (int run = 0; run < runs; ++run)
+            copies.push_back(arena.copy(words_to_copy.begin(), words_to_copy.end()));
+    }
+
+    DocumentArena arena;
+    std::vector<PmrDocumentContent> copies;
+};
 
-    BENCHMARK_ADVANCED("parallel")
-    (Catch::Benchmark::Chronometer meter)
+// Copying the words is timed and counted apart from sorting them: the sort benchmarks get
+// a fresh unsorted copy for every run, prepared before the measurement
+const BenchmarkGroup sort_arena_benchmarks{"sort - arena allocation", {
+    {"copy - std::allocator", [](size_t size) {
+         return [sized_words = words_of_size(size)] {
+             auto copy = *sized_words;
+             return copy.size();
+         };
+     }},
+    {"copy - monotonic arena", [](size_t size) {
+         return [sized_words = words_of_size(size), arena = std::make_shared<DocumentArena>(ArenaKind::monotonic)] { return copy_and_reset(*arena, *sized_words); };
+     }},
+    {"copy - pool arena", [](size_t size) {
+         return [sized_words = words_of_size(size), arena = std::make_shared<DocumentArena>(ArenaKind::pool)] { return copy_and_reset(*arena, *sized_words); };
+     }},
+    {"parallel - std::allocator", [](size_t size, int runs) {
+         return [copies = std::vector<DocumentContent>(runs, *words_of_size(size))](int run) mutable {
+             std::sort(std::execution::par, copies[run].begin(), copies[run].end());
+             return copies[run].front();
+         };
+     }},
+    {"parallel - monotonic arena", [](size_t size, int runs) {
+         return [copies = std::make_shared<ArenaCopies>(ArenaKind::monotonic, *words_of_size(size), runs)](int run) {
+             auto &copy = copies->copies[run];
+             std::sort(std::execution::par, copy.begin(), copy.end());
+             return copy.front();
+         };
+     }},
+    {"parallel - pool arena", [](size_t size, int runs) {
+         return [copies = std::make_shared<ArenaCopies>(ArenaKind::pool, *words_of_size(size), runs)](int run) {
+             auto &copy = copies->copies[run];
+             std::sort(std::execution::par, copy.begin(), copy.end());
+             return copy.front();
+         };
+     }},
+}};
+
+// Allocation counts of the copies: --arena-report
+TEST_CASE("sort - arena allocation")
+{
+    const bool report = benchmark_options().arena_report;
+
+    DocumentArena heap{ArenaKind::none};
+    DocumentArena monotonic{ArenaKind::monotonic};
+    DocumentArena pool{ArenaKind::pool};
+
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+    if (report)
     {
-        auto words_to_sort = words;
-        REQUIRE_FALSE(std::is_sorted(words_to_sort.begin(), words_to_sort.end()));
+        std::printf("\nCopy of %zu words - two rounds, reset in between\n", words.size());
+        std::printf("  %-12s %6s %12s %12s %12s %14s\n", "", "round", "time [ms]", "requests", "new/delete", "new'd [MB]");
+    }
 
-        meter.measure([&] {
-            std::sort(
-                std::execution::par,
-                words_to_sort.begin(), words_to_sort.end(),
-                [](const auto &a, const auto &b) { return boost::to_lower_copy(a) < boost::to_lower_copy(b); });
+    for (auto *arena : {&heap, &monotonic, &pool})
+    {
+        for (int round = 1; round <= 2; ++round)
+        {
+            arena->reset();
+            const auto start = std::chrono::steady_clock::now();
+            {
+                const auto copy = arena->copy(words.begin(), words.end());
+                REQUIRE(std::equal(copy.begin(), copy.end(), words.begin(), words.end(), [](const auto &a, const auto &b) { return std::string_view{a} == b; }));
+            }
+            const Milliseconds time = std::chrono::steady_clock::now() - start;
 
-            return words_to_sort.front();
-        });
-    };
+            if (report)
+            {
+                const char *names[] = {"new/delete", "monotonic", "pool"};
+                std::printf("  %-12s %6d %12.2f %12zu %12zu %14.1f\n", names[static_cast<int>(arena->kind())], round, time.count(),
+                    arena->requests().allocations, arena->upstream().allocations, arena->upstream().bytes / 1e6);
+            }
+        }
+    }
+
+    sort_arena_benchmarks.run(words.size());
+}
+
+// Sorts the words of the file in memory and writes them to output_file_name, one per line
+size_t sort_in_memory(const std::string &input_file_name, const std::string &output_file_name)
+{
+    const auto input_words = load_words_mapped(std::execution::par, input_file_name).value();
+    auto words_to_sort = input_words.words();
+    std::sort(std::execution::par, words_to_sort.begin(), words_to_sort.end());
 
-    BENCHMARK_ADVANCED("parallel unsequenced")
-    (Catch::Benchmark::Chronometer meter)
+    std::ofstream output_file{output_file_name, std::ios::binary};
+    for (const auto &word : words_to_sort)
+        output_file << word << '\n';
+    return words_to_sort.size();
+}
+
+// A directory of its own in the temp directory for the runs and the outputs of the external sorts,
+// removed with everything in it at exit
+const std::filesystem::path &external_sort_directory()
+{
+    static const struct Directory
     {
-        auto words_to_sort = words;
-        REQUIRE_FALSE(std::is_sorted(words_to_sort.begin(), words_to_sort.end()));
+        Directory()
+            : path{std::filesystem::temp_directory_path() / ("pstl-external-sort-" + std::to_string(std::random_device{}()))}
+        {
+            std::filesystem::create_directories(path);
+        }
 
-        meter.measure([&] {
-            std::for_each(std::execution::par, words_to_sort.begin(), words_to_sort.end(), [](auto &w) { boost::to_lower(w); });
-            std::vector<std::string_view> words_views(words_to_sort.size());
-            std::transform(std::execution::par, words_to_sort.begin(), words_to_sort.end(), words_views.begin(), [](const auto &w) { return std::string_view(w); });
+        ~Directory()
+        {
+            std::error_code error;
+            std::filesystem::remove_all(path, error);
+        }
 
-            std::sort(
-                std::execution::par_unseq,
-                words_views.begin(), words_views.end());
+        std::filesystem::path path;
+    } directory;
 
-            return std::string(words_views.front());
-        });
+    return directory.path;
+}
+
+std::string external_sort_output(const std::string &file_name)
+{
+    return (external_sort_directory() / file_name).string();
+}
+
+ExternalSortSettings external_sort_settings()
+{
+    ExternalSortSettings settings;
+    settings.run_bytes = benchmark_options().external_sort_run_bytes;
+    settings.temp_directory = external_sort_directory();
+    return settings;
+}
+
+const BenchmarkGroup sort_external_benchmarks{"sort - external", {
+    {"parallel - in memory", [](size_t size) {
+         return [file_name = words_file_of_size(size)] { return sort_in_memory(*file_name, external_sort_output("sorted_in_memory.txt")); };
+     }},
+    {"sequenced - external", [](size_t size) {
+         return [file_name = words_file_of_size(size), settings = external_sort_settings()] { return external_sort(*file_name, external_sort_output("sorted_external.txt"), settings)->no_of_runs; };
+     }},
+    {"parallel - external", [](size_t size) {
+         return [file_name = words_file_of_size(size), settings = external_sort_settings()] {
+             return external_sort(std::execution::par, *file_name, external_sort_output("sorted_external.txt"), settings)->no_of_runs;
+         };
+     }},
+}};
+
+// Input of the correctness check: --external-sort-input <file>, memory of a run: --external-sort-run-bytes <bytes>.
+// The benchmarks sort as many words as the input has - any size of the scaling sweep as well.
+TEST_CASE("sort - external")
+{
+    const BenchmarkOptions &options = benchmark_options();
+
+    auto read_file = [](const std::string &file_name) {
+        std::ifstream input_file{file_name, std::ios::binary};
+        return std::string{std::istreambuf_iterator<char>{input_file}, std::istreambuf_iterator<char>{}};
+    };
+
+    const auto sorted_external = external_sort_output("sorted_external.txt");
+    const auto sorted_in_memory = external_sort_output("sorted_in_memory.txt");
+
+    const auto stats = external_sort(std::execution::par, options.external_sort_input, sorted_external, external_sort_settings());
+    REQUIRE(stats);
+    REQUIRE(stats->no_of_words == sort_in_memory(options.external_sort_input, sorted_in_memory));
+    REQUIRE(read_file(sorted_external) == read_file(sorted_in_memory));
+    std::cout << "External sort: " << stats->no_of_words << " words, " << stats->no_of_runs << " runs" << std::endl;
+
+    sort_external_benchmarks.run(stats->no_of_words);
+}
+
+// load, lower-case, create views and sort - one phase after another over the whole file, each on all
+// threads and with the lower-casing kernel of the pipeline, so only the overlap of the phases differs
+std::pair<DocumentContent, std::vector<std::string_view>> sort_serial_phases(const std::string &file_name)
+{
+    auto loaded_words = load_words(file_name).value();
+    std::for_each(std::execution::par, loaded_words.begin(), loaded_words.end(), [](auto &word) { to_lower_fast(word); });
+
+    std::vector<std::string_view> words_views(loaded_words.begin(), loaded_words.end());
+    std::sort(std::execution::par, words_views.begin(), words_views.end());
+    return std::pair{std::move(loaded_words), std::move(words_views)};
+}
+
+std::pair<WordPipelineResult, std::vector<std::string_view>> sort_pipelined(const std::string &file_name, const WordPipelineSettings &settings = {})
+{
+    auto result = sort_runs_pipelined(file_name, settings).value();
+    auto merged = merge_sorted_runs(result.runs);
+    return std::pair{std::move(result), std::move(merged)};
+}
+
+const BenchmarkGroup sort_pipelined_benchmarks{"sort - pipelined", {
+    {"serial phases", [](size_t size) {
+         return [file_name = words_file_of_size(size)] { return sort_serial_phases(*file_name).second.size(); };
+     }},
+    {"pipelined - runs", [](size_t size) {
+         return [file_name = words_file_of_size(size), settings = benchmark_pipeline_settings()] { return sort_runs_pipelined(*file_name, settings)->runs.size(); };
+     }},
+    {"pipelined - runs + merge", [](size_t size) {
+         return [file_name = words_file_of_size(size), settings = benchmark_pipeline_settings()] { return sort_pipelined(*file_name, settings).second.size(); };
+     }},
+}};
+
+TEST_CASE("sort - pipelined")
+{
+    const std::string file_name = "tokens.txt";
+    const size_t no_of_bytes = MappedFile::open(file_name).value().size();
+
+    const auto [serial_words, serial_sorted] = sort_serial_phases(file_name);
+    const auto [pipelined_runs, pipelined_sorted] = sort_pipelined(file_name);
+    REQUIRE(pipelined_sorted == serial_sorted);
+
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+    auto report = [&](const char *name, Milliseconds first_result, Milliseconds total) {
+        std::printf("  %-28s %12.2f %12.2f %14.1f %14.0f\n", name, first_result.count(), total.count(),
+            no_of_bytes / 1e3 / total.count(), serial_sorted.size() / total.count() * 1e3);
     };
+
+    std::printf("\nPipelined sort - %s (%zu words)\n", file_name.c_str(), serial_sorted.size());
+    std::printf("  %-28s %12s %12s %14s %14s\n", "", "first [ms]", "total [ms]", "MB/s", "words/s");
+    {
+        const auto start = std::chrono::steady_clock::now();
+        sort_serial_phases(file_name);
+        const Milliseconds total = std::chrono::steady_clock::now() - start;
+        report("serial phases", total, total);
+    }
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const auto [result, merged] = sort_pipelined(file_name);
+        report("pipelined - runs", result.time_to_first_run, result.total_time);
+        report("pipelined - runs + merge", result.time_to_first_run, std::chrono::steady_clock::now() - start);
+    }
+
+    sort_pipelined_benchmarks.run(serial_sorted.size());
+}
+
+std::unordered_map<std::string_view, size_t> count_unordered_map(const DocumentContent &words_to_count)
+{
+    std::unordered_map<std::string_view, size_t> frequencies;
+    for (const auto &word : words_to_count)
+        ++frequencies[word];
+    return frequencies;
+}
+
+const BenchmarkGroup word_frequencies_benchmarks{"word frequencies", {
+    {"sequenced - std::unordered_map", [](size_t size) {
+         return [sized_words = words_of_size(size)] { return count_unordered_map(*sized_words); };
+     }},
+    {"parallel - std::map with mutex", [](size_t size) {
+         return [sized_words = words_of_size(size)] {
+             std::map<std::string_view, size_t> frequencies;
+             std::mutex mtx;
+             std::for_each(std::execution::par, sized_words->begin(), sized_words->end(), [&](const auto &word) {
+                 std::lock_guard lock{mtx};
+                 ++frequencies[word];
+             });
+             return frequencies;
+         };
+     }},
+    {"sequenced - sharded", [](size_t size) {
+         return [sized_words = words_of_size(size)] { return count_words(sized_words->begin(), sized_words->end()); };
+     }},
+    {"parallel - sharded", [](size_t size) {
+         return [sized_words = words_of_size(size)] { return count_words(std::execution::par, sized_words->begin(), sized_words->end()); };
+     }},
+}};
+
+TEST_CASE("word frequencies")
+{
+    const auto expected = count_unordered_map(words);
+    const auto sharded = count_words(std::execution::par, words.begin(), words.end());
+    REQUIRE(sharded.size() == expected.size());
+    REQUIRE(std::all_of(expected.begin(), expected.end(), [&](const auto &item) { return sharded.count(item.first) == item.second; }));
+
+    word_frequencies_benchmarks.run(words.size());
+}
+
+constexpr size_t heavy_hitters_k = 10;
+constexpr size_t heavy_hitters_capacity = 1000;
+
+const BenchmarkGroup heavy_hitters_benchmarks{"heavy hitters", {
+    {"exact - parallel - sharded", [](size_t size) {
+         return [sized_words = words_of_size(size)] { return count_words(std::execution::par, sized_words->begin(), sized_words->end()).most_frequent(heavy_hitters_k); };
+     }},
+    {"sequenced - space saving", [](size_t size) {
+         return [sized_words = words_of_size(size)] { return heavy_hitters(sized_words->begin(), sized_words->end(), heavy_hitters_capacity).top(heavy_hitters_k); };
+     }},
+    {"parallel - space saving", [](size_t size) {
+         return [sized_words = words_of_size(size)] {
+             return heavy_hitters(std::execution::par, sized_words->begin(), sized_words->end(), heavy_hitters_capacity, 4 * 1024).top(heavy_hitters_k);
+         };
+     }},
+}};
+
+TEST_CASE("heavy hitters")
+{
+    const auto exact = count_words(std::execution::par, words.begin(), words.end());
+    const auto sketch = heavy_hitters(std::execution::par, words.begin(), words.end(), heavy_hitters_capacity);
+    REQUIRE(sketch.total_count() == words.size());
+
+    std::cout << "Top " << heavy_hitters_k << " words - max error: " << sketch.max_error() << " (bound N/capacity: " << words.size() / heavy_hitters_capacity << ")\n";
+    for (const auto &hitter : sketch.top(heavy_hitters_k))
+    {
+        std::cout << "  " << hitter.word << ": " << hitter.guaranteed_count() << " - " << hitter.count << " (exact: " << exact.count(hitter.word) << ")\n";
+        REQUIRE(hitter.guaranteed_count() <= exact.count(hitter.word));
+        REQUIRE(exact.count(hitter.word) <= hitter.count);
+    }
+
+    heavy_hitters_benchmarks.run(words.size());
+}
+
+const std::vector<std::string_view> phrase_query = {"of", "the"};
+
+std::vector<uint32_t> scan_phrase(const DocumentContent &words_to_scan)
+{
+    std::vector<uint32_t> starts;
+    for (size_t i = 0; i + phrase_query.size() <= words_to_scan.size(); ++i)
+    {
+        if (std::equal(phrase_query.begin(), phrase_query.end(), words_to_scan.begin() + i))
+            starts.push_back(static_cast<uint32_t>(i));
+    }
+    return starts;
+}
+
+const BenchmarkGroup inverted_index_benchmarks{"inverted index", {
+    {"build - sequenced", [](size_t size) {
+         return [sized_words = words_of_size(size)] { return InvertedIndex{sized_words->begin(), sized_words->end()}.no_of_bytes(); };
+     }},
+    {"build - parallel", [](size_t size) {
+         return [sized_words = words_of_size(size)] { return InvertedIndex{std::execution::par, sized_words->begin(), sized_words->end()}.no_of_bytes(); };
+     }},
+    {"query word - linear scan", [](size_t size) {
+         return [sized_words = words_of_size(size)] { return std::count(sized_words->begin(), sized_words->end(), phrase_query.back()); };
+     }, 1},
+    {"query word - index", [](size_t size) {
+         const auto sized_words = words_of_size(size);
+         return [index = std::make_shared<const InvertedIndex>(std::execution::par, sized_words->begin(), sized_words->end())] {
+             return index->positions(phrase_query.back()).size();
+         };
+     }, 1},
+    {"query phrase - linear scan", [](size_t size) {
+         return [sized_words = words_of_size(size)] { return scan_phrase(*sized_words); };
+     }, 1},
+    {"query phrase - index", [](size_t size) {
+         const auto sized_words = words_of_size(size);
+         return [index = std::make_shared<const InvertedIndex>(std::execution::par, sized_words->begin(), sized_words->end())] {
+             return index->phrase(phrase_query);
+         };
+     }, 1},
+}};
+
+TEST_CASE("inverted index")
+{
+    const InvertedIndex index{std::execution::par, words.begin(), words.end()};
+    REQUIRE(index.phrase(phrase_query) == scan_phrase(words));
+    std::cout << "Inverted index: " << index.no_of_terms() << " terms, " << index.no_of_bytes() << " bytes of postings ("
+              << words.size() * sizeof(uint32_t) << " bytes uncompressed)" << std::endl;
+
+    inverted_index_benchmarks.run(words.size());
+}
+
+template <typename ExecutionPolicy>
+DocumentContent sort_unique(ExecutionPolicy &&policy, DocumentContent unique)
+{
+    std::sort(policy, unique.begin(), unique.end());
+    unique.erase(std::unique(policy, unique.begin(), unique.end()), unique.end());
+    return unique;
+}
+
+const BenchmarkGroup unique_words_benchmarks{"unique words", {
+    {"sequenced - sort + unique", [](size_t size) {
+         return [sized_words = words_of_size(size)] { return sort_unique(std::execution::seq, *sized_words); };
+     }},
+    {"parallel - sort + unique", [](size_t size) {
+         return [sized_words = words_of_size(size)] { return sort_unique(std::execution::par, *sized_words); };
+     }},
+    {"sequenced - concurrent set", [](size_t size) {
+         return [sized_words = words_of_size(size)] { return unique_words(sized_words->begin(), sized_words->end()); };
+     }},
+    {"parallel - concurrent set", [](size_t size) {
+         return [sized_words = words_of_size(size)] { return unique_words(std::execution::par, sized_words->begin(), sized_words->end()); };
+     }},
+    {"parallel - concurrent set - moved strings", [](size_t size) {
+         return [sized_words = words_of_size(size)] {
+             auto to_dedup = *sized_words;
+             return unique_words(std::execution::par, std::move(to_dedup));
+         };
+     }},
+}};
+
+TEST_CASE("unique words")
+{
+    const auto expected = sort_unique(std::execution::seq, words);
+    auto unique = unique_words(std::execution::par, words.begin(), words.end());
+    std::sort(unique.begin(), unique.end());
+    REQUIRE(std::equal(unique.begin(), unique.end(), expected.begin(), expected.end()));
+
+    unique_words_benchmarks.run(words.size());
 }
 
 bool is_prime(uint64_t number)
@@ -145,52 +882,335 @@ const std::vector<uint64_t> numbers = [] {
     return numbers;
 }();
 
+inline const PrimeTable prime_table{std::execution::par, no_of_items};
+
+const std::vector<uint64_t> wide_numbers = [] {
+    std::random_device rd;
+    std::mt19937_64 rnd_gen{rd()};
+    std::uniform_int_distribution<uint64_t> rnd_distr(0, std::numeric_limits<uint64_t>::max());
+
+    std::vector<uint64_t> numbers(no_of_items);
+    std::generate(numbers.begin(), numbers.end(), [&] { return rnd_distr(rnd_gen); });
+
+    return numbers;
+}();
+
+// Every size draws from the values of numbers, up to no_of_items - the range of the prime table
+std::shared_ptr<const std::vector<uint64_t>> numbers_of_size(size_t size)
+{
+    return repeated(numbers, size);
+}
+
+std::shared_ptr<const std::vector<uint64_t>> wide_numbers_of_size(size_t size)
+{
+    return repeated(wide_numbers, size);
+}
+
+const BenchmarkGroup transform_benchmarks{"transform", {
+    {"sequenced", [](size_t size) {
+         return [numbers_to_part = numbers_of_size(size), are_primes = std::vector<uint64_t>(size)]() mutable {
+             std::transform(numbers_to_part->begin(), numbers_to_part->end(), are_primes.begin(), [](auto n) { return is_prime(n); });
+             return are_primes;
+         };
+     }},
+    {"parallel", [](size_t size) {
+         return [numbers_to_part = numbers_of_size(size), are_primes = std::vector<uint64_t>(size)]() mutable {
+             std::transform(std::execution::par_unseq, numbers_to_part->begin(), numbers_to_part->end(), are_primes.begin(), [](auto n) { return is_prime(n); });
+             return are_primes;
+         };
+     }},
+    {"parallel - work stealing pool", [](size_t size) {
+         return [policy = pstl::PoolPolicy{benchmark_pool()}, numbers_to_part = numbers_of_size(size), are_primes = std::vector<uint64_t>(size)]() mutable {
+             pstl::transform(policy, numbers_to_part->begin(), numbers_to_part->end(), are_primes.begin(), [](auto n) { return is_prime(n); });
+             return are_primes;
+         };
+     }},
+    {"parallel - work stealing pool - grain 256", [](size_t size) {
+         return [policy = pstl::PoolPolicy{benchmark_pool(), 256}, numbers_to_part = numbers_of_size(size), are_primes = std::vector<uint64_t>(size)]() mutable {
+             pstl::transform(policy, numbers_to_part->begin(), numbers_to_part->end(), are_primes.begin(), [](auto n) { return is_prime(n); });
+             return are_primes;
+         };
+     }},
+    {"parallel - work stealing pool - pinned", [](size_t size) {
+         return [policy = pstl::PoolPolicy{benchmark_pool(Affinity::pinned)}, numbers_to_part = numbers_of_size(size), are_primes = std::vector<uint64_t>(size)]() mutable {
+             pstl::transform(policy, numbers_to_part->begin(), numbers_to_part->end(), are_primes.begin(), [](auto n) { return is_prime(n); });
+             return are_primes;
+         };
+     }},
+    {"sequenced - sieve", [](size_t size) {
+         return [numbers_to_part = numbers_of_size(size), are_primes = std::vector<uint64_t>(size)]() mutable {
+             std::transform(numbers_to_part->begin(), numbers_to_part->end(), are_primes.begin(), [](auto n) { return prime_table.is_prime(n); });
+             return are_primes;
+         };
+     }},
+    {"parallel - sieve", [](size_t size) {
+         return [numbers_to_part = numbers_of_size(size), are_primes = std::vector<uint64_t>(size)]() mutable {
+             std::transform(std::execution::par_unseq, numbers_to_part->begin(), numbers_to_part->end(), are_primes.begin(), [](auto n) { return prime_table.is_prime(n); });
+             return are_primes;
+         };
+     }},
+    {"parallel - sieve including build", [](size_t size) {
+         return [numbers_to_part = numbers_of_size(size), are_primes = std::vector<uint64_t>(size)]() mutable {
+             const PrimeTable primes{std::execution::par, no_of_items};
+             std::transform(std::execution::par_unseq, numbers_to_part->begin(), numbers_to_part->end(), are_primes.begin(), [&](auto n) { return primes.is_prime(n); });
+             return are_primes;
+         };
+     }},
+}};
+
 TEST_CASE("transform")
 {
-    BENCHMARK_ADVANCED("sequenced")
-    (Catch::Benchmark::Chronometer meter)
-    {
-        auto numbers_to_part = numbers;
-        decltype(numbers_to_part) are_primes(numbers_to_part.size());
+    REQUIRE(std::all_of(numbers.begin(), numbers.end(), [](auto n) { return prime_table.is_prime(n) == is_prime(n); }));
 
-        meter.measure([&] {
-            std::transform(numbers_to_part.begin(), numbers_to_part.end(), are_primes.begin(), [](auto n) { return is_prime(n); });
-            return are_primes;
-        });
-    };
+    transform_benchmarks.run(numbers.size());
+}
 
-    BENCHMARK_ADVANCED("parallel")
-    (Catch::Benchmark::Chronometer meter)
-    {
-        auto numbers_to_part = numbers;
-        decltype(numbers_to_part) are_primes(numbers_to_part.size());
+// The dense list of primes instead of one flag per number
+const BenchmarkGroup copy_if_benchmarks{"copy_if", {
+    {"sequenced - std::copy_if", [](size_t size) {
+         return [numbers_to_copy = numbers_of_size(size), primes = std::vector<uint64_t>(size)]() mutable {
+             return std::copy_if(numbers_to_copy->begin(), numbers_to_copy->end(), primes.begin(), [](auto n) { return is_prime(n); }) - primes.begin();
+         };
+     }},
+    {"parallel - std::copy_if", [](size_t size) {
+         return [numbers_to_copy = numbers_of_size(size), primes = std::vector<uint64_t>(size)]() mutable {
+             return std::copy_if(std::execution::par, numbers_to_copy->begin(), numbers_to_copy->end(), primes.begin(), [](auto n) { return is_prime(n); }) - primes.begin();
+         };
+     }},
+    {"parallel - compact", [](size_t size) {
+         return [numbers_to_copy = numbers_of_size(size), primes = std::vector<uint64_t>(size)]() mutable {
+             return compact(std::execution::par, numbers_to_copy->begin(), numbers_to_copy->end(), primes.begin(), [](auto n) { return is_prime(n); }) - primes.begin();
+         };
+     }},
+    {"parallel - compact simd", [](size_t size) {
+         return [numbers_to_copy = numbers_of_size(size), primes = std::vector<uint64_t>(size)]() mutable {
+             return compact_simd(std::execution::par, numbers_to_copy->data(), numbers_to_copy->data() + numbers_to_copy->size(), primes.data(), [](auto n) { return is_prime(n); }) - primes.data();
+         };
+     }},
+    // With the cheap predicate the copying itself is what is measured
+    {"parallel - std::copy_if - sieve", [](size_t size) {
+         return [numbers_to_copy = numbers_of_size(size), primes = std::vector<uint64_t>(size)]() mutable {
+             return std::copy_if(std::execution::par, numbers_to_copy->begin(), numbers_to_copy->end(), primes.begin(), [](auto n) { return prime_table.is_prime(n); }) - primes.begin();
+         };
+     }},
+    {"parallel - compact - sieve", [](size_t size) {
+         return [numbers_to_copy = numbers_of_size(size), primes = std::vector<uint64_t>(size)]() mutable {
+             return compact(std::execution::par, numbers_to_copy->begin(), numbers_to_copy->end(), primes.begin(), [](auto n) { return prime_table.is_prime(n); }) - primes.begin();
+         };
+     }},
+    {"parallel - compact simd - sieve", [](size_t size) {
+         return [numbers_to_copy = numbers_of_size(size), primes = std::vector<uint64_t>(size)]() mutable {
+             return compact_simd(std::execution::par, numbers_to_copy->data(), numbers_to_copy->data() + numbers_to_copy->size(), primes.data(), [](auto n) { return prime_table.is_prime(n); })
+                 - primes.data();
+         };
+     }},
+}};
 
-        meter.measure([&] {
-            std::transform(std::execution::par_unseq, numbers_to_part.begin(), numbers_to_part.end(), are_primes.begin(), [](auto n) { return is_prime(n); });
-            return are_primes;
-        });
-    };
+TEST_CASE("copy_if")
+{
+    std::vector<uint64_t> expected;
+    std::copy_if(numbers.begin(), numbers.end(), std::back_inserter(expected), [](auto n) { return prime_table.is_prime(n); });
+
+    std::vector<uint64_t> primes(numbers.size());
+    REQUIRE(std::equal(primes.begin(), compact(std::execution::par, numbers.begin(), numbers.end(), primes.begin(), [](auto n) { return is_prime(n); }), expected.begin(), expected.end()));
+    REQUIRE(std::equal(primes.data(), compact_simd(std::execution::par, numbers.data(), numbers.data() + numbers.size(), primes.data(), [](auto n) { return is_prime(n); }), expected.begin(), expected.end()));
+
+    copy_if_benchmarks.run(numbers.size());
 }
 
+const BenchmarkGroup transform_wide_benchmarks{"transform - 64-bit numbers", {
+    {"sequenced - miller rabin", [](size_t size) {
+         return [numbers_to_part = wide_numbers_of_size(size), are_primes = std::vector<uint64_t>(size)]() mutable {
+             std::transform(numbers_to_part->begin(), numbers_to_part->end(), are_primes.begin(), [](auto n) { return is_prime_miller_rabin(n); });
+             return are_primes;
+         };
+     }},
+    {"sequenced - miller rabin batched", [](size_t size) {
+         return [numbers_to_part = wide_numbers_of_size(size), are_primes = std::vector<uint64_t>(size)]() mutable {
+             is_prime_miller_rabin(numbers_to_part->begin(), numbers_to_part->end(), are_primes.begin());
+             return are_primes;
+         };
+     }},
+    {"parallel - miller rabin", [](size_t size) {
+         return [numbers_to_part = wide_numbers_of_size(size), are_primes = std::vector<uint64_t>(size)]() mutable {
+             std::transform(std::execution::par_unseq, numbers_to_part->begin(), numbers_to_part->end(), are_primes.begin(), [](auto n) { return is_prime_miller_rabin(n); });
+             return are_primes;
+         };
+     }},
+    {"parallel - miller rabin batched", [](size_t size) {
+         return [numbers_to_part = wide_numbers_of_size(size), are_primes = std::vector<uint64_t>(size)]() mutable {
+             is_prime_miller_rabin(std::execution::par, numbers_to_part->begin(), numbers_to_part->end(), are_primes.begin());
+             return are_primes;
+         };
+     }},
+}};
+
+TEST_CASE("transform - 64-bit numbers")
+{
+    REQUIRE(std::all_of(numbers.begin(), numbers.end(), [](auto n) { return is_prime_miller_rabin(n) == is_prime(n); }));
+
+    transform_wide_benchmarks.run(wide_numbers.size());
+}
+
+using Parts = std::pair<std::vector<uint64_t>, std::vector<uint64_t>>;
+
+// Every thread appends to its own pair of buffers, which are concatenated afterwards -
+// the packed slots put the vectors of several threads into one cache line, the cases are always counted
+template <typename PerThreadParts>
+std::vector<uint64_t>::iterator partition_per_thread(PerThreadParts &parts, std::vector<uint64_t> &numbers_to_part)
+{
+    std::for_each(std::execution::par, numbers_to_part.begin(), numbers_to_part.end(), [&](auto n) {
+        auto &[primes, others] = parts.local();
+        (prime_table.is_prime(n) ? primes : others).push_back(n);
+    });
+
+    auto out = numbers_to_part.begin();
+    parts.for_each([&](const auto &part) { out = std::copy(part.first.begin(), part.first.end(), out); });
+    const auto middle = out;
+    parts.for_each([&](const auto &part) { out = std::copy(part.second.begin(), part.second.end(), out); });
+    return middle;
+}
+
+const BenchmarkGroup partition_benchmarks{"partition", {
+    {"sequenced", [](size_t size) {
+         return [numbers_to_part = *numbers_of_size(size)]() mutable {
+             return std::partition(numbers_to_part.begin(), numbers_to_part.end(), [](auto n) { return is_prime(n); });
+         };
+     }},
+    {"parallel unsequenced", [](size_t size) {
+         return [numbers_to_part = *numbers_of_size(size)]() mutable {
+             return std::partition(std::execution::par_unseq, numbers_to_part.begin(), numbers_to_part.end(), [](auto n) { return is_prime(n); });
+         };
+     }},
+    {"parallel - work stealing pool", [](size_t size) {
+         return [policy = pstl::PoolPolicy{benchmark_pool()}, numbers_to_part = *numbers_of_size(size)]() mutable {
+             return pstl::partition(policy, numbers_to_part.begin(), numbers_to_part.end(), [](auto n) { return is_prime(n); });
+         };
+     }},
+    {"sequenced - std::stable_partition", [](size_t size) {
+         return [numbers_to_part = *numbers_of_size(size)]() mutable {
+             return std::stable_partition(numbers_to_part.begin(), numbers_to_part.end(), [](auto n) { return is_prime(n); });
+         };
+     }},
+    {"sequenced - blocked stable", [](size_t size) {
+         return [numbers_to_part = *numbers_of_size(size)]() mutable {
+             return blocked_stable_partition(numbers_to_part.begin(), numbers_to_part.end(), [](auto n) { return is_prime(n); });
+         };
+     }},
+    {"parallel - blocked stable", [](size_t size) {
+         return [numbers_to_part = *numbers_of_size(size)]() mutable {
+             return blocked_stable_partition(std::execution::par, numbers_to_part.begin(), numbers_to_part.end(), [](auto n) { return is_prime(n); });
+         };
+     }},
+    {"sequenced - sieve", [](size_t size) {
+         return [numbers_to_part = *numbers_of_size(size)]() mutable {
+             return std::partition(numbers_to_part.begin(), numbers_to_part.end(), [](auto n) { return prime_table.is_prime(n); });
+         };
+     }},
+    {"parallel unsequenced - sieve", [](size_t size) {
+         return [numbers_to_part = *numbers_of_size(size)]() mutable {
+             return std::partition(std::execution::par_unseq, numbers_to_part.begin(), numbers_to_part.end(), [](auto n) { return prime_table.is_prime(n); });
+         };
+     }},
+    BenchmarkCase{"parallel - per_thread buffers - padded - sieve", [](size_t size) {
+         return [numbers_to_part = *numbers_of_size(size)]() mutable {
+             PerThread<Parts> parts;
+             return partition_per_thread(parts, numbers_to_part);
+         };
+     }}.with_counters(),
+    BenchmarkCase{"parallel - per_thread buffers - packed - sieve", [](size_t size) {
+         return [numbers_to_part = *numbers_of_size(size)]() mutable {
+             PerThread<Parts, alignof(Parts)> parts;
+             return partition_per_thread(parts, numbers_to_part);
+         };
+     }}.with_counters(),
+}};
+
 TEST_CASE("partition")
 {
-    BENCHMARK_ADVANCED("sequenced")
-    (Catch::Benchmark::Chronometer meter)
+    partition_benchmarks.run(numbers.size());
+}
+
+// Every case of every benchmark group, sizes: --sizes n1,n2,... (default: the number of words),
+// thread counts: --threads t1,t2,... (default: 1, 2, 4, ... cores). The pool and pipeline cases
+// run on threads of their own sized to the thread count, see benchmark_pool().
+TEST_CASE("scaling sweep", "[.][scaling]")
+{
+    const auto cases = BenchmarkGroup::all_scaling_cases();
+
+    const BenchmarkOptions &options = benchmark_options();
+    const auto sizes = options.sizes.empty() ? std::vector<size_t>{words.size()} : options.sizes;
+    const auto threads = options.threads.empty() ? default_thread_counts() : options.threads;
+
+    const auto points = run_scaling_sweep(cases, sizes, threads, options.repetitions);
+    REQUIRE(points.size() == 2 * cases.size() * sizes.size() * threads.size());
+
+    if (options.scaling_output.empty())
+    {
+        write_csv(std::cout, points);
+    }
+    else
     {
-        auto numbers_to_part = numbers;
+        std::ofstream output_file{options.scaling_output};
+        REQUIRE(output_file);
 
-        meter.measure([&] {
-            return std::partition(numbers_to_part.begin(), numbers_to_part.end(), [](auto n) { return is_prime(n); });
-        });
+        const auto &file_name = options.scaling_output;
+        if (file_name.size() >= 5 && file_name.compare(file_name.size() - 5, 5, ".json") == 0)
+            write_json(output_file, points);
+        else
+            write_csv(output_file, points);
+    }
+}
+
+// Per-thread timelines of the prime predicates - run with --trace <file> and open the file in a trace viewer
+TEST_CASE("transform - traced", "[.][trace]")
+{
+    constexpr int no_of_runs = 3;
+
+    auto traced_is_prime = [](auto n) {
+        trace::Zone zone{"is_prime"};
+        return is_prime(n);
     };
 
-    BENCHMARK_ADVANCED("parallel unsequenced")
-    (Catch::Benchmark::Chronometer meter)
+    auto numbers_to_part = numbers;
+    std::vector<uint64_t> are_primes(numbers_to_part.size());
+
+    for (int run = 0; run < no_of_runs; ++run)
     {
-        auto numbers_to_part = numbers;
+        {
+            trace::Zone zone{"transform - sequenced"};
+            std::transform(numbers_to_part.begin(), numbers_to_part.end(), are_primes.begin(), traced_is_prime);
+        }
 
-        meter.measure([&] {
-            return std::partition(std::execution::par_unseq, numbers_to_part.begin(), numbers_to_part.end(), [](auto n) { return is_prime(n); });
-        });
-    };
-}
\ No newline at end of file
+        {
+            trace::Zone zone{"transform - parallel"};
+            std::transform(std::execution::par_unseq, numbers_to_part.begin(), numbers_to_part.end(), are_primes.begin(), traced_is_prime);
+        }
+
+        {
+            trace::Zone zone{"partition - parallel"};
+            auto to_partition = numbers;
+            std::partition(std::execution::par_unseq, to_partition.begin(), to_partition.end(), traced_is_prime);
+        }
+    }
+
+    REQUIRE(std::count(are_primes.begin(), are_primes.end(), 1) == std::count_if(numbers.begin(), numbers.end(), [](auto n) { return is_prime(n); }));
+}
+
+// Writes a corpus file of --corpus-bytes - e.g. for load words benchmarks at production sizes
+TEST_CASE("generate corpus", "[.][corpus]")
+{
+    const BenchmarkOptions &options = benchmark_options();
+    const ZipfCorpus corpus{options.corpus};
+
+    const auto start = std::chrono::steady_clock::now();
+    REQUIRE(corpus.write_file(std::execution::par, options.corpus_file, options.corpus_bytes));
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << "Corpus: " << options.corpus_file << " - " << options.corpus_bytes << " bytes in " << elapsed.count() << " s ("
+              << options.corpus_bytes / elapsed.count() / 1e6 << " MB/s)" << std::endl;
+
+    const auto corpus_words = load_words_mapped(options.corpus_file);
+    REQUIRE(corpus_words);
+    REQUIRE(corpus_words->text().size() == options.corpus_bytes);
+}
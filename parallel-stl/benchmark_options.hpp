@@ -0,0 +1,89 @@
+#pragma once
+
+#include "zipf_corpus.hpp"
+
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Settings of the benchmark binary - read from PSTL_* environment variables,
+// command line options (see main.cpp) take precedence
+struct BenchmarkOptions
+{
+    std::vector<size_t> sizes;   // data sizes of the scaling sweep - empty: the default dataset
+    std::vector<size_t> threads; // thread counts of the scaling sweep - empty: 1, 2, 4, ... cores
+    size_t repetitions = 5;
+    std::string scaling_output; // .csv or .json - empty: CSV on standard output
+    bool perf_counters = false;
+    bool histograms = false;
+    std::string histogram_directory; // raw histograms as CSV files - empty: percentiles only
+    std::string trace_output;        // Chrome trace JSON of all trace::Zone scopes - empty: tracing disabled
+    size_t corpus_words = 0;         // words of a generated corpus instead of tokens.txt - environment only, read before main
+    CorpusSettings corpus;
+    std::string corpus_file = "corpus.txt";
+    uint64_t corpus_bytes = 64 * 1024 * 1024;
+    std::string external_sort_input = "tokens.txt";
+    size_t external_sort_run_bytes = 128 * 1024;
+    bool arena_report = false; // allocation counts of the arenas in the "sort - arena allocation" test case
+
+    static std::vector<size_t> parse_list(const std::string &text)
+    {
+        std::vector<size_t> values;
+        std::istringstream input{text};
+        for (std::string item; std::getline(input, item, ',');)
+        {
+            if (!item.empty())
+                values.push_back(std::stoull(item));
+        }
+        return values;
+    }
+
+    static BenchmarkOptions from_environment()
+    {
+        BenchmarkOptions options;
+
+        if (const char *sizes = std::getenv("PSTL_SIZES"))
+            options.sizes = parse_list(sizes);
+        if (const char *threads = std::getenv("PSTL_THREADS"))
+            options.threads = parse_list(threads);
+        if (const char *repetitions = std::getenv("PSTL_REPETITIONS"))
+            options.repetitions = std::stoull(repetitions);
+        if (const char *scaling_output = std::getenv("PSTL_SCALING_OUTPUT"))
+            options.scaling_output = scaling_output;
+        if (const char *perf_counters = std::getenv("PSTL_PERF_COUNTERS"))
+            options.perf_counters = std::string(perf_counters) != "0";
+        if (const char *histograms = std::getenv("PSTL_HISTOGRAMS"))
+            options.histograms = std::string(histograms) != "0";
+        if (const char *histogram_directory = std::getenv("PSTL_HISTOGRAM_DIR"))
+            options.histogram_directory = histogram_directory;
+        if (const char *trace_output = std::getenv("PSTL_TRACE"))
+            options.trace_output = trace_output;
+        if (const char *corpus_words = std::getenv("PSTL_CORPUS_WORDS"))
+            options.corpus_words = std::stoull(corpus_words);
+        if (const char *vocabulary_size = std::getenv("PSTL_CORPUS_VOCABULARY"))
+            options.corpus.vocabulary_size = std::stoull(vocabulary_size);
+        if (const char *exponent = std::getenv("PSTL_CORPUS_EXPONENT"))
+            options.corpus.exponent = std::stod(exponent);
+        if (const char *seed = std::getenv("PSTL_CORPUS_SEED"))
+            options.corpus.seed = std::stoull(seed);
+        if (const char *corpus_file = std::getenv("PSTL_CORPUS_FILE"))
+            options.corpus_file = corpus_file;
+        if (const char *corpus_bytes = std::getenv("PSTL_CORPUS_BYTES"))
+            options.corpus_bytes = std::stoull(corpus_bytes);
+        if (const char *external_sort_input = std::getenv("PSTL_EXTERNAL_SORT_INPUT"))
+            options.external_sort_input = external_sort_input;
+        if (const char *external_sort_run_bytes = std::getenv("PSTL_EXTERNAL_SORT_RUN_BYTES"))
+            options.external_sort_run_bytes = std::stoull(external_sort_run_bytes);
+        if (const char *arena_report = std::getenv("PSTL_ARENA_REPORT"))
+            options.arena_report = std::string(arena_report) != "0";
+
+        return options;
+    }
+};
+
+inline BenchmarkOptions &benchmark_options()
+{
+    static BenchmarkOptions options = BenchmarkOptions::from_environment();
+    return options;
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include "catch.hpp"
+#include "measurement.hpp"
+#include "perf_counters.hpp"
+#include "scaling.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace benchmark_registry_detail
+{
+    template <typename Call>
+    decltype(auto) call_run(Call &call, int run)
+    {
+        if constexpr (std::is_invocable_v<Call &, int>)
+            return call(run);
+        else
+            return call();
+    }
+} // namespace benchmark_registry_detail
+
+// One benchmark of a group. prepare(size) or prepare(size, runs) builds the untimed input of size
+// elements and returns the measured call - call() or call(run), the index of the run of a sample,
+// for cases that modify their input and prepare a copy for every run. Results of the call
+// are kept from being optimized away.
+struct BenchmarkCase
+{
+    using Call = std::function<void(int run)>;
+
+    template <typename Prepare>
+    BenchmarkCase(std::string name, Prepare prepare, std::optional<size_t> elements = std::nullopt)
+        : name{std::move(name)}, elements{elements}
+    {
+        this->prepare = [prepare = std::move(prepare)](size_t size, int runs) -> Call {
+            auto call = [&] {
+                if constexpr (std::is_invocable_v<const Prepare &, size_t, int>)
+                    return prepare(size, runs);
+                else
+                    return prepare(size);
+            }();
+
+            return [call = std::move(call)](int run) mutable {
+                using Result = decltype(benchmark_registry_detail::call_run(call, run));
+                if constexpr (std::is_void_v<Result>)
+                    benchmark_registry_detail::call_run(call, run);
+                else
+                    Catch::Benchmark::deoptimize_value(benchmark_registry_detail::call_run(call, run));
+            };
+        };
+    }
+
+    // Counted with the hardware counters even without --perf-counters
+    BenchmarkCase with_counters() &&
+    {
+        counters = true;
+        return std::move(*this);
+    }
+
+    std::string name;
+    std::function<Call(size_t size, int runs)> prepare;
+    std::optional<size_t> elements; // of one call - none: the size
+    bool counters = false;
+};
+
+// The benchmarks of one test case. Every group registers itself, the scaling sweep runs the cases
+// of all groups, so a case added to a group is part of the sweep as well.
+class BenchmarkGroup
+{
+public:
+    BenchmarkGroup(std::string name, std::vector<BenchmarkCase> cases)
+        : name_{std::move(name)}, cases_{std::move(cases)}
+    {
+        registered().push_back(this);
+    }
+
+    BenchmarkGroup(const BenchmarkGroup &) = delete;
+    BenchmarkGroup &operator=(const BenchmarkGroup &) = delete;
+
+    ~BenchmarkGroup()
+    {
+        auto &groups = registered();
+        groups.erase(std::remove(groups.begin(), groups.end(), this), groups.end());
+    }
+
+    static const std::vector<const BenchmarkGroup *> &all()
+    {
+        return registered();
+    }
+
+    const std::string &name() const noexcept
+    {
+        return name_;
+    }
+
+    const std::vector<BenchmarkCase> &cases() const noexcept
+    {
+        return cases_;
+    }
+
+    // A Catch benchmark of every case with input of size elements - call from the test case of the group
+    void run(size_t size) const
+    {
+        for (const auto &benchmark : cases_)
+        {
+            std::optional<PerfCountersScope> counters;
+            if (benchmark.counters)
+                counters.emplace();
+
+            BENCHMARK_ADVANCED(std::string{benchmark.name})
+            (Catch::Benchmark::Chronometer meter)
+            {
+                auto call = benchmark.prepare(size, meter.runs());
+
+                MeasurementScope measurement{benchmark.elements.value_or(size), static_cast<size_t>(meter.runs())};
+                if (measurement.times_calls())
+                    meter.measure([&](int run) { measurement.time_call([&] { call(run); }); });
+                else
+                    meter.measure([&](int run) { call(run); });
+            };
+        }
+    }
+
+    // The cases as cases of the scaling sweep, named "<group> - <case>"
+    std::vector<ScalingCase> scaling_cases() const
+    {
+        std::vector<ScalingCase> cases;
+        for (const auto &benchmark : cases_)
+        {
+            cases.push_back({name_ + " - " + benchmark.name, [&benchmark](size_t size) {
+                                 auto call = benchmark.prepare(size, 1);
+                                 return time_it([&] { call(0); });
+                             }});
+        }
+        return cases;
+    }
+
+    // The cases of all registered groups
+    static std::vector<ScalingCase> all_scaling_cases()
+    {
+        std::vector<ScalingCase> cases;
+        for (const auto *group : registered())
+        {
+            auto group_cases = group->scaling_cases();
+            cases.insert(cases.end(), group_cases.begin(), group_cases.end());
+        }
+        return cases;
+    }
+
+private:
+    static std::vector<const BenchmarkGroup *> &registered()
+    {
+        static std::vector<const BenchmarkGroup *> groups;
+        return groups;
+    }
+
+    std::string name_;
+    std::vector<BenchmarkCase> cases_;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <algorithm>
+#include <boost/algorithm/string.hpp>
+#include <execution>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Orders words like comparing boost::to_lower_copy(a) < boost::to_lower_copy(b),
+// but every word is folded once into a key (decorate-sort-undecorate)
+template <typename ExecutionPolicy, typename String>
+void sort_case_insensitive(ExecutionPolicy &&policy, std::vector<String> &words)
+{
+    std::vector<std::string> keys(words.size());
+    std::transform(policy, words.begin(), words.end(), keys.begin(), [](const auto &word) {
+        std::string key(word);
+        boost::to_lower(key);
+        return key;
+    });
+
+    struct DecoratedWord
+    {
+        std::string_view key;
+        size_t index;
+    };
+
+    std::vector<size_t> indexes(words.size());
+    std::iota(indexes.begin(), indexes.end(), size_t{0});
+
+    std::vector<DecoratedWord> decorated_words(words.size());
+    std::transform(policy, indexes.begin(), indexes.end(), decorated_words.begin(), [&keys](size_t index) {
+        return DecoratedWord{keys[index], index};
+    });
+
+    std::sort(policy, decorated_words.begin(), decorated_words.end(), [](const auto &a, const auto &b) { return a.key < b.key; });
+
+    std::vector<String> sorted_words(words.size());
+    std::transform(policy, decorated_words.begin(), decorated_words.end(), sorted_words.begin(), [&words](const auto &decorated_word) {
+        return std::move(words[decorated_word.index]);
+    });
+
+    words = std::move(sorted_words);
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "intrinsics.hpp"
+#include "stable_partition.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <execution>
+#include <iterator>
+#include <type_traits>
+
+#ifdef PSTL_HAS_AVX2_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace compaction_detail
+{
+    // Kernels copy the elements of [first, first + size) with a set bit in mask to [out, out_last)
+    // - size is a multiple of 64 or the rest of the input, out_last - out the number of set bits
+    using Kernel = void (*)(const uint64_t *first, size_t size, const uint64_t *mask, uint64_t *out, uint64_t *out_last);
+
+    inline void compact_scalar(const uint64_t *first, size_t size, const uint64_t *mask, uint64_t *out, uint64_t *)
+    {
+        for (size_t word_first = 0; word_first < size; word_first += 64)
+        {
+            for (uint64_t bits = mask[word_first / 64]; bits; bits &= bits - 1)
+                *out++ = first[word_first + count_trailing_zeros(bits)];
+        }
+    }
+
+#ifdef PSTL_HAS_AVX2_DISPATCH
+    // 32-bit lane indexes that move the selected 64-bit elements of 4 to the front, for every 4-bit mask
+    inline const std::array<std::array<int, 8>, 16> &permutations()
+    {
+        alignas(32) static const auto table = [] {
+            std::array<std::array<int, 8>, 16> table{};
+            for (int selection = 0; selection < 16; ++selection)
+            {
+                int lane = 0;
+                for (int element = 0; element < 4; ++element)
+                {
+                    if (selection & (1 << element))
+                    {
+                        table[selection][lane++] = 2 * element;
+                        table[selection][lane++] = 2 * element + 1;
+                    }
+                }
+            }
+            return table;
+        }();
+        return table;
+    }
+
+    // Four elements at a time: the selected ones are permuted to the front of the register and all
+    // four are stored - the unselected tail is overwritten by the next store. Groups at the end of
+    // the input or of the output go element by element.
+    __attribute__((target("avx2,popcnt"))) inline void compact_avx2(const uint64_t *first, size_t size, const uint64_t *mask, uint64_t *out, uint64_t *out_last)
+    {
+        const auto &table = permutations();
+
+        for (size_t word_first = 0; word_first < size; word_first += 64)
+        {
+            const uint64_t bits = mask[word_first / 64];
+            const size_t word_size = std::min<size_t>(64, size - word_first);
+
+            for (size_t i = 0; i < word_size && bits >> i; i += 4)
+            {
+                const unsigned selection = (bits >> i) & 0xF;
+                if (i + 4 <= word_size && out_last - out >= 4)
+                {
+                    const __m256i elements = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(first + word_first + i));
+                    const __m256i permutation = _mm256_load_si256(reinterpret_cast<const __m256i *>(table[selection].data()));
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), _mm256_permutevar8x32_epi32(elements, permutation));
+                    out += count_ones(selection);
+                }
+                else
+                {
+                    for (unsigned rest = selection; rest; rest &= rest - 1)
+                        *out++ = first[word_first + i + count_trailing_zeros(rest)];
+                }
+            }
+        }
+    }
+#endif
+
+    inline Kernel select_kernel()
+    {
+#ifdef PSTL_HAS_AVX2_DISPATCH
+        if (__builtin_cpu_supports("avx2"))
+            return compact_avx2;
+#endif
+        return compact_scalar;
+    }
+} // namespace compaction_detail
+
+// Dense copy_if: every block evaluates pred into a bitmask and counts the selected elements,
+// a prefix sum of the counts gives every block its place in the output, then the blocks copy
+// their selected elements there. Returns the end of the output, like std::copy_if.
+template <typename ExecutionPolicy, typename RandomAccessIterator, typename RandomAccessOutputIterator, typename Predicate,
+    typename = std::enable_if_t<std::is_execution_policy_v<std::decay_t<ExecutionPolicy>>>>
+RandomAccessOutputIterator compact(ExecutionPolicy &&policy, RandomAccessIterator first, RandomAccessIterator last, RandomAccessOutputIterator out, Predicate pred, size_t block_size = 4096)
+{
+    const size_t size = std::distance(first, last);
+    const auto masks = stable_partition_detail::evaluate_blocks(policy, first, size, pred, block_size);
+
+    std::for_each(policy, masks.blocks.begin(), masks.blocks.end(), [&](size_t block) {
+        auto block_out = out + masks.trues_before[block];
+        for (size_t i = block * masks.block_size; i < std::min(size, (block + 1) * masks.block_size); ++i)
+        {
+            if (masks.is_true(i))
+                *block_out++ = first[i];
+        }
+    });
+
+    return out + masks.total_trues();
+}
+
+template <typename RandomAccessIterator, typename RandomAccessOutputIterator, typename Predicate>
+RandomAccessOutputIterator compact(RandomAccessIterator first, RandomAccessIterator last, RandomAccessOutputIterator out, Predicate pred, size_t block_size = 4096)
+{
+    return compact(std::execution::seq, first, last, out, pred, block_size);
+}
+
+// compact() for 64-bit numbers with the copy done in AVX2 registers where the CPU has them
+template <typename ExecutionPolicy, typename Predicate,
+    typename = std::enable_if_t<std::is_execution_policy_v<std::decay_t<ExecutionPolicy>>>>
+uint64_t *compact_simd(ExecutionPolicy &&policy, const uint64_t *first, const uint64_t *last, uint64_t *out, Predicate pred, size_t block_size = 4096)
+{
+    static const compaction_detail::Kernel kernel = compaction_detail::select_kernel();
+
+    const size_t size = last - first;
+    const auto masks = stable_partition_detail::evaluate_blocks(policy, first, size, pred, block_size);
+
+    std::for_each(policy, masks.blocks.begin(), masks.blocks.end(), [&](size_t block) {
+        const size_t block_first = block * masks.block_size;
+        kernel(first + block_first, std::min(size - block_first, masks.block_size), masks.mask.data() + block_first / 64,
+            out + masks.trues_before[block], out + masks.trues_before[block + 1]);
+    });
+
+    return out + masks.total_trues();
+}
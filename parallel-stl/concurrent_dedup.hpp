@@ -0,0 +1,148 @@
+#pragma once
+
+#include "fast_hash.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <execution>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Insert-only lock-free hash set of words identified by their position in a random-access range.
+// A slot packs the high half of the hash with the position + 1, so one CAS publishes an entry.
+// Equal words keep the lowest position - after all inserts the set holds the first occurrences.
+template <typename RandomAccessIterator>
+class ConcurrentWordSet
+{
+public:
+    ConcurrentWordSet(RandomAccessIterator words, size_t max_size)
+        : words_{words}
+    {
+        if (max_size >= position_mask)
+            throw std::length_error("ConcurrentWordSet: too many words");
+
+        size_t capacity = 16;
+        while (capacity < 2 * max_size)
+            capacity *= 2;
+
+        mask_ = capacity - 1;
+        slots_ = std::make_unique<std::atomic<uint64_t>[]>(capacity);
+        for (size_t i = 0; i < capacity; ++i)
+            slots_[i].store(0, std::memory_order_relaxed);
+    }
+
+    // Safe to call concurrently for different positions
+    void insert(size_t position, uint64_t hash) noexcept
+    {
+        const uint64_t desired = (hash & ~position_mask) | (position + 1);
+        const std::string_view word{words_[position]};
+
+        for (size_t i = hash & mask_;; i = (i + 1) & mask_)
+        {
+            uint64_t current = slots_[i].load(std::memory_order_acquire);
+            while (true)
+            {
+                if (current == 0)
+                {
+                    if (slots_[i].compare_exchange_weak(current, desired, std::memory_order_acq_rel))
+                        return;
+                    continue;
+                }
+
+                const size_t current_position = (current & position_mask) - 1;
+                if ((current & ~position_mask) != (desired & ~position_mask) || std::string_view{words_[current_position]} != word)
+                    break; // another word - probe the next slot
+
+                if (current_position <= position
+                    || slots_[i].compare_exchange_weak(current, desired, std::memory_order_acq_rel))
+                    return;
+            }
+        }
+    }
+
+    // Positions of the distinct words in ascending order - call after all inserts finished
+    template <typename ExecutionPolicy>
+    std::vector<size_t> positions(ExecutionPolicy &&policy) const
+    {
+        std::vector<size_t> result;
+        for (size_t i = 0; i <= mask_; ++i)
+        {
+            if (const uint64_t slot = slots_[i].load(std::memory_order_relaxed); slot != 0)
+                result.push_back((slot & position_mask) - 1);
+        }
+
+        std::sort(policy, result.begin(), result.end());
+        return result;
+    }
+
+private:
+    static constexpr uint64_t position_mask = 0xFFFF'FFFFULL;
+
+    RandomAccessIterator words_;
+    size_t mask_;
+    std::unique_ptr<std::atomic<uint64_t>[]> slots_;
+};
+
+namespace concurrent_dedup_detail
+{
+    template <typename ExecutionPolicy, typename RandomAccessIterator>
+    std::vector<size_t> first_occurrences(ExecutionPolicy &&policy, RandomAccessIterator first, RandomAccessIterator last, size_t block_size)
+    {
+        const size_t size = std::distance(first, last);
+        ConcurrentWordSet<RandomAccessIterator> word_set{first, size};
+
+        std::vector<size_t> blocks((size + block_size - 1) / block_size);
+        std::iota(blocks.begin(), blocks.end(), size_t{0});
+
+        std::for_each(policy, blocks.begin(), blocks.end(), [&](size_t block) {
+            const size_t block_first = block * block_size;
+            const size_t block_last = std::min(size, block_first + block_size);
+
+            std::vector<std::string_view> block_words(first + block_first, first + block_last);
+            std::vector<uint64_t> hashes(block_words.size());
+            fast_hash(block_words.begin(), block_words.end(), hashes.begin());
+
+            for (size_t i = 0; i < hashes.size(); ++i)
+                word_set.insert(block_first + i, hashes[i]);
+        });
+
+        return word_set.positions(policy);
+    }
+} // namespace concurrent_dedup_detail
+
+// Distinct words in the order of their first occurrence - views into the input
+template <typename ExecutionPolicy, typename RandomAccessIterator,
+    typename = std::enable_if_t<std::is_execution_policy_v<std::decay_t<ExecutionPolicy>>>>
+std::vector<std::string_view> unique_words(ExecutionPolicy &&policy, RandomAccessIterator first, RandomAccessIterator last, size_t block_size = 4 * 1024)
+{
+    const auto positions = concurrent_dedup_detail::first_occurrences(policy, first, last, block_size);
+
+    std::vector<std::string_view> result(positions.size());
+    std::transform(policy, positions.begin(), positions.end(), result.begin(), [&](size_t position) { return std::string_view{first[position]}; });
+    return result;
+}
+
+template <typename RandomAccessIterator>
+std::vector<std::string_view> unique_words(RandomAccessIterator first, RandomAccessIterator last)
+{
+    return unique_words(std::execution::seq, first, last);
+}
+
+// Distinct words in the order of their first occurrence - moved out of the consumed input
+template <typename ExecutionPolicy, typename = std::enable_if_t<std::is_execution_policy_v<std::decay_t<ExecutionPolicy>>>>
+std::vector<std::string> unique_words(ExecutionPolicy &&policy, std::vector<std::string> &&words, size_t block_size = 4 * 1024)
+{
+    const auto positions = concurrent_dedup_detail::first_occurrences(policy, words.begin(), words.end(), block_size);
+
+    std::vector<std::string> result(positions.size());
+    std::transform(policy, positions.begin(), positions.end(), result.begin(), [&](size_t position) { return std::move(words[position]); });
+    words.clear();
+    return result;
+}
@@ -0,0 +1,364 @@
+#pragma once
+
+#include "loser_tree.hpp"
+#include "pipeline.hpp"
+#include "tokenizer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <execution>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+struct ExternalSortSettings
+{
+    size_t run_bytes = 64 * 1024 * 1024;           // input text sorted in memory at once - a run is in each stage of
+                                                   // read -> sort -> write and one waits between two stages
+    size_t buffer_bytes = 4 * 1024 * 1024;         // of every run reader and of the writer
+    size_t max_fan_in = 256;                       // runs merged at once - more runs are merged in passes
+    size_t merge_memory_bytes = 256 * 1024 * 1024; // buffers of one merge - limits the fan-in to merge_memory_bytes / buffer_bytes - 1
+    std::filesystem::path temp_directory = std::filesystem::temp_directory_path();
+};
+
+struct ExternalSortStats
+{
+    size_t no_of_words = 0;
+    size_t no_of_runs = 0;
+    size_t no_of_merge_passes = 0;
+};
+
+namespace external_sort_detail
+{
+    class BufferedWriter
+    {
+    public:
+        BufferedWriter(const std::filesystem::path &file_name, size_t buffer_bytes)
+            : output_file_{file_name, std::ios::binary}, buffer_(std::max<size_t>(buffer_bytes, 1))
+        {
+        }
+
+        ~BufferedWriter()
+        {
+            flush();
+        }
+
+        explicit operator bool() const
+        {
+            return static_cast<bool>(output_file_);
+        }
+
+        void write_line(std::string_view word)
+        {
+            if (used_ + word.size() + 1 > buffer_.size())
+            {
+                flush();
+                if (word.size() + 1 > buffer_.size())
+                {
+                    output_file_.write(word.data(), word.size()).put('\n');
+                    return;
+                }
+            }
+
+            std::memcpy(buffer_.data() + used_, word.data(), word.size());
+            used_ += word.size();
+            buffer_[used_++] = '\n';
+        }
+
+        bool flush()
+        {
+            output_file_.write(buffer_.data(), used_);
+            used_ = 0;
+            output_file_.flush();
+            return static_cast<bool>(output_file_);
+        }
+
+    private:
+        std::ofstream output_file_;
+        std::vector<char> buffer_;
+        size_t used_ = 0;
+    };
+
+    // Reads one word per line in large blocks - a returned view stays valid until the next call
+    class RunReader
+    {
+    public:
+        RunReader(const std::filesystem::path &file_name, size_t buffer_bytes)
+            : input_file_{file_name, std::ios::binary}, buffer_(std::max<size_t>(buffer_bytes, 2))
+        {
+        }
+
+        explicit operator bool() const
+        {
+            return input_file_.is_open();
+        }
+
+        std::optional<std::string_view> next()
+        {
+            while (true)
+            {
+                const char *line_end = static_cast<const char *>(std::memchr(buffer_.data() + begin_, '\n', end_ - begin_));
+                if (line_end)
+                {
+                    std::string_view word{buffer_.data() + begin_, static_cast<size_t>(line_end - buffer_.data()) - begin_};
+                    begin_ += word.size() + 1;
+                    return word;
+                }
+
+                if (eof_)
+                {
+                    if (begin_ == end_)
+                        return std::nullopt;
+                    std::string_view word{buffer_.data() + begin_, end_ - begin_}; // no final line break
+                    begin_ = end_;
+                    return word;
+                }
+
+                refill();
+            }
+        }
+
+    private:
+        void refill()
+        {
+            const size_t remaining = end_ - begin_;
+            if (remaining == buffer_.size())
+                buffer_.resize(buffer_.size() * 2); // a word longer than the buffer
+
+            std::memmove(buffer_.data(), buffer_.data() + begin_, remaining);
+            begin_ = 0;
+            end_ = remaining;
+
+            input_file_.read(buffer_.data() + end_, buffer_.size() - end_);
+            end_ += static_cast<size_t>(input_file_.gcount());
+            eof_ = !input_file_;
+        }
+
+        std::ifstream input_file_;
+        std::vector<char> buffer_;
+        size_t begin_ = 0;
+        size_t end_ = 0;
+        bool eof_ = false;
+    };
+
+    // Run files of one sort - removed with the object
+    class TempFiles
+    {
+    public:
+        explicit TempFiles(std::filesystem::path directory)
+            : directory_{std::move(directory)}
+        {
+            static std::atomic<size_t> no_of_sorts = 0;
+            prefix_ = "external_sort_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + "_" + std::to_string(no_of_sorts++) + "_";
+        }
+
+        TempFiles(const TempFiles &) = delete;
+        TempFiles &operator=(const TempFiles &) = delete;
+
+        ~TempFiles()
+        {
+            std::error_code ec;
+            for (const auto &file_name : files_)
+                std::filesystem::remove(file_name, ec);
+        }
+
+        std::filesystem::path create()
+        {
+            files_.push_back(directory_ / (prefix_ + std::to_string(files_.size()) + ".txt"));
+            return files_.back();
+        }
+
+        void remove(const std::filesystem::path &file_name)
+        {
+            std::error_code ec;
+            std::filesystem::remove(file_name, ec);
+        }
+
+    private:
+        std::filesystem::path directory_;
+        std::string prefix_;
+        std::vector<std::filesystem::path> files_;
+    };
+
+    // Runs merged at once - the readers and the writer of a merge stay within merge_memory_bytes
+    inline size_t fan_in(const ExternalSortSettings &settings)
+    {
+        const size_t buffers = settings.merge_memory_bytes / std::max<size_t>(settings.buffer_bytes, 1);
+        return std::max<size_t>(std::min(settings.max_fan_in, buffers > 0 ? buffers - 1 : 0), 2);
+    }
+
+    // The words of a run, sorted - views into the text of the run
+    struct SortedRunText
+    {
+        std::vector<char> text;
+        std::vector<std::string_view> words;
+    };
+
+    struct WriteError
+    {
+    };
+
+    template <typename Compare>
+    bool merge_runs(const std::vector<std::filesystem::path> &runs, const std::filesystem::path &output_file, const ExternalSortSettings &settings, Compare comp)
+    {
+        std::vector<RunReader> readers;
+        readers.reserve(runs.size());
+        std::vector<std::optional<std::string_view>> heads;
+        for (const auto &run : runs)
+        {
+            readers.emplace_back(run, settings.buffer_bytes);
+            if (!readers.back())
+                return false;
+            heads.push_back(readers.back().next());
+        }
+
+        BufferedWriter writer{output_file, settings.buffer_bytes};
+        if (!writer)
+            return false;
+
+        LoserTree<std::string_view, Compare> tree{std::move(heads), comp};
+        while (!tree.empty())
+        {
+            writer.write_line(tree.top());
+            tree.replace_top(readers[tree.top_source()].next());
+        }
+
+        return writer.flush();
+    }
+} // namespace external_sort_detail
+
+// Sorts the whitespace-separated words of input_file into output_file (one word per line) with
+// memory bounded by run_bytes and merge_memory_bytes: sorted runs are spilled to temporary files, then
+// merged k-way through a loser tree. The runs are generated by a pipeline - the next run is read while
+// the current one is sorted and the one before is written. Tokenizing and sorting of a run use the
+// policy. Gives the same order as std::sort with comp.
+template <typename ExecutionPolicy, typename Compare = std::less<>,
+    typename = std::enable_if_t<std::is_execution_policy_v<std::decay_t<ExecutionPolicy>>>>
+std::optional<ExternalSortStats> external_sort(ExecutionPolicy &&policy, const std::string &input_file, const std::string &output_file,
+    const ExternalSortSettings &settings = {}, Compare comp = Compare{})
+{
+    using namespace external_sort_detail;
+
+    std::ifstream input{input_file, std::ios::binary};
+    if (!input)
+        return std::nullopt;
+
+    ExternalSortStats stats;
+    TempFiles temp_files{settings.temp_directory};
+    std::vector<std::filesystem::path> runs;
+
+    BoundedQueue<std::vector<char>> run_texts{1};
+    BoundedQueue<SortedRunText> sorted_runs{1};
+
+    Pipeline pipeline;
+    pipeline.add_source(run_texts, [&](auto emit) {
+        std::vector<char> text(std::max<size_t>(settings.run_bytes, 1));
+        size_t carried = 0; // start of a word cut by the previous read
+
+        while (true)
+        {
+            input.read(text.data() + carried, text.size() - carried);
+            const size_t size = carried + static_cast<size_t>(input.gcount());
+            const bool last_run = !input;
+
+            size_t run_end = size;
+            if (!last_run)
+            {
+                while (run_end > 0 && !is_space(text[run_end - 1]))
+                    --run_end;
+                if (run_end == 0) // a word longer than the run
+                {
+                    text.resize(text.size() * 2);
+                    carried = size;
+                    continue;
+                }
+            }
+
+            if (last_run)
+            {
+                text.resize(size);
+                emit(std::move(text));
+                return;
+            }
+
+            std::vector<char> next_text(text.size());
+            carried = size - run_end;
+            std::memcpy(next_text.data(), text.data() + run_end, carried);
+
+            text.resize(run_end);
+            if (!emit(std::move(text)))
+                return;
+            text = std::move(next_text);
+        }
+    });
+
+    pipeline.add_stage(run_texts, sorted_runs, 1, [&](std::vector<char> text) {
+        auto words = tokenize(policy, std::string_view{text.data(), text.size()});
+        std::sort(policy, words.begin(), words.end(), comp);
+        return SortedRunText{std::move(text), std::move(words)};
+    });
+
+    pipeline.add_sink(sorted_runs, 1, [&](SortedRunText run) {
+        if (run.words.empty())
+            return;
+
+        runs.push_back(temp_files.create());
+        BufferedWriter writer{runs.back(), settings.buffer_bytes};
+        for (const auto &word : run.words)
+            writer.write_line(word);
+        if (!writer.flush())
+            throw WriteError{};
+
+        stats.no_of_words += run.words.size();
+    });
+
+    try
+    {
+        pipeline.wait();
+    }
+    catch (const WriteError &)
+    {
+        return std::nullopt;
+    }
+
+    stats.no_of_runs = runs.size();
+
+    const size_t max_fan_in = fan_in(settings);
+    while (runs.size() > max_fan_in)
+    {
+        std::vector<std::filesystem::path> merged_runs;
+        for (size_t first = 0; first < runs.size(); first += max_fan_in)
+        {
+            const std::vector<std::filesystem::path> group(runs.begin() + first, runs.begin() + std::min(runs.size(), first + max_fan_in));
+            merged_runs.push_back(temp_files.create());
+            if (!merge_runs(group, merged_runs.back(), settings, comp))
+                return std::nullopt;
+
+            for (const auto &run : group)
+                temp_files.remove(run);
+        }
+
+        runs = std::move(merged_runs);
+        ++stats.no_of_merge_passes;
+    }
+
+    if (!merge_runs(runs, output_file, settings, comp))
+        return std::nullopt;
+    ++stats.no_of_merge_passes;
+
+    return stats;
+}
+
+template <typename Compare = std::less<>>
+std::optional<ExternalSortStats> external_sort(const std::string &input_file, const std::string &output_file, const ExternalSortSettings &settings = {}, Compare comp = Compare{})
+{
+    return external_sort(std::execution::seq, input_file, output_file, settings, comp);
+}
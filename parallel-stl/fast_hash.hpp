@@ -0,0 +1,172 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string_view>
+
+#include "mul_high.hpp"
+
+// Non-cryptographic 64-bit hash in the style of wyhash: keys are folded 16 bytes at a time
+// with 64x64 -> 128-bit multiplications
+namespace fast_hash_detail
+{
+    constexpr std::array<uint64_t, 4> secret = {0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL, 0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL};
+
+    constexpr size_t no_of_lanes = 4;
+
+    inline void multiply(uint64_t &a, uint64_t &b) noexcept
+    {
+        const uint64_t low = a * b;
+        b = mul_high(a, b);
+        a = low;
+    }
+
+    inline uint64_t mix(uint64_t a, uint64_t b) noexcept
+    {
+        multiply(a, b);
+        return a ^ b;
+    }
+
+    inline uint64_t read8(const char *p) noexcept
+    {
+        uint64_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    inline uint64_t read4(const char *p) noexcept
+    {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    inline uint64_t read3(const char *p, size_t length) noexcept
+    {
+        return (uint64_t{static_cast<unsigned char>(p[0])} << 16) | (uint64_t{static_cast<unsigned char>(p[length >> 1])} << 8)
+            | static_cast<unsigned char>(p[length - 1]);
+    }
+
+    inline uint64_t initial_state(uint64_t seed) noexcept
+    {
+        return seed ^ mix(seed ^ secret[0], secret[1]);
+    }
+
+    // Loads the two final words of a key of at most 16 bytes
+    inline void load_short(const char *p, size_t length, uint64_t &a, uint64_t &b) noexcept
+    {
+        if (length >= 4)
+        {
+            const size_t shift = (length >> 3) << 2;
+            a = (read4(p) << 32) | read4(p + shift);
+            b = (read4(p + length - 4) << 32) | read4(p + length - 4 - shift);
+        }
+        else if (length > 0)
+        {
+            a = read3(p, length);
+            b = 0;
+        }
+        else
+        {
+            a = b = 0;
+        }
+    }
+
+    inline uint64_t finish(uint64_t a, uint64_t b, uint64_t state, size_t length) noexcept
+    {
+        a ^= secret[1];
+        b ^= state;
+        multiply(a, b);
+        return mix(a ^ secret[0] ^ length, b ^ secret[1]);
+    }
+} // namespace fast_hash_detail
+
+inline uint64_t fast_hash(std::string_view key, uint64_t seed = 0) noexcept
+{
+    using namespace fast_hash_detail;
+
+    const char *p = key.data();
+    const size_t length = key.size();
+    uint64_t state = initial_state(seed);
+    uint64_t a, b;
+
+    if (length <= 16)
+    {
+        load_short(p, length, a, b);
+    }
+    else
+    {
+        size_t remaining = length;
+        if (remaining > 48)
+        {
+            uint64_t state1 = state, state2 = state;
+            do
+            {
+                state = mix(read8(p) ^ secret[1], read8(p + 8) ^ state);
+                state1 = mix(read8(p + 16) ^ secret[2], read8(p + 24) ^ state1);
+                state2 = mix(read8(p + 32) ^ secret[3], read8(p + 40) ^ state2);
+                p += 48;
+                remaining -= 48;
+            } while (remaining > 48);
+            state ^= state1 ^ state2;
+        }
+
+        while (remaining > 16)
+        {
+            state = mix(read8(p) ^ secret[1], read8(p + 8) ^ state);
+            p += 16;
+            remaining -= 16;
+        }
+
+        a = read8(p + remaining - 16);
+        b = read8(p + remaining - 8);
+    }
+
+    return finish(a, b, state, length);
+}
+
+// Hashes keys four at a time - short keys (the common case for words) go through
+// the final multiplications in lockstep, so their latencies overlap
+template <typename InputIterator, typename OutputIterator>
+OutputIterator fast_hash(InputIterator first, InputIterator last, OutputIterator out, uint64_t seed = 0)
+{
+    using namespace fast_hash_detail;
+
+    const uint64_t state = initial_state(seed);
+    std::array<std::string_view, no_of_lanes> keys;
+
+    while (first != last)
+    {
+        size_t count = 0;
+        for (; count < no_of_lanes && first != last; ++count, ++first)
+            keys[count] = std::string_view(*first);
+
+        const bool all_short = count == no_of_lanes && keys[0].size() <= 16 && keys[1].size() <= 16 && keys[2].size() <= 16 && keys[3].size() <= 16;
+
+        if (!all_short)
+        {
+            for (size_t lane = 0; lane < count; ++lane)
+                *out++ = fast_hash(keys[lane], seed);
+            continue;
+        }
+
+        std::array<uint64_t, no_of_lanes> a, b;
+        for (size_t lane = 0; lane < no_of_lanes; ++lane)
+            load_short(keys[lane].data(), keys[lane].size(), a[lane], b[lane]);
+
+        for (size_t lane = 0; lane < no_of_lanes; ++lane)
+        {
+            a[lane] ^= secret[1];
+            b[lane] ^= state;
+            multiply(a[lane], b[lane]);
+        }
+
+        for (size_t lane = 0; lane < no_of_lanes; ++lane)
+            *out++ = mix(a[lane] ^ secret[0] ^ keys[lane].size(), b[lane] ^ secret[1]);
+    }
+
+    return out;
+}
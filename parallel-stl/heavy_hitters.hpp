@@ -0,0 +1,242 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <execution>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+struct HeavyHitter
+{
+    std::string_view word;
+    uint64_t count = 0; // estimate - never below the true count
+    uint64_t error = 0; // the true count is in [count - error, count]
+
+    uint64_t guaranteed_count() const noexcept
+    {
+        return count - error;
+    }
+};
+
+// Space-Saving sketch: monitors at most capacity words, an unmonitored word replaces the one with
+// the smallest counter and inherits its count as error. Every word occurring more than
+// total_count() / capacity times is monitored. Keys are views - the input has to outlive the sketch.
+class SpaceSaving
+{
+public:
+    explicit SpaceSaving(size_t capacity)
+        : capacity_{capacity}
+    {
+        if (capacity == 0)
+            throw std::invalid_argument("SpaceSaving: capacity must be positive");
+
+        counters_.reserve(capacity);
+        heap_.reserve(capacity);
+        heap_positions_.reserve(capacity);
+        slots_.reserve(capacity);
+    }
+
+    void add(std::string_view word, uint64_t count = 1)
+    {
+        total_count_ += count;
+
+        if (auto it = slots_.find(word); it != slots_.end())
+        {
+            counters_[it->second].count += count;
+            sift_down(heap_positions_[it->second]);
+        }
+        else if (counters_.size() < capacity_)
+        {
+            slots_.emplace(word, counters_.size());
+            counters_.push_back(HeavyHitter{word, count, 0});
+            heap_positions_.push_back(heap_.size());
+            heap_.push_back(counters_.size() - 1);
+            sift_up(heap_.size() - 1);
+        }
+        else
+        {
+            const size_t slot = heap_[0];
+            const uint64_t min_count = counters_[slot].count;
+
+            slots_.erase(counters_[slot].word);
+            slots_.emplace(word, slot);
+            counters_[slot] = HeavyHitter{word, min_count + count, min_count};
+            sift_down(0);
+        }
+    }
+
+    // Mergeable summaries (Agarwal et al.): a word missing in one sketch may have
+    // occurred there up to its minimal counter times
+    void merge(const SpaceSaving &other)
+    {
+        const uint64_t own_min = min_count();
+        const uint64_t other_min = other.min_count();
+
+        std::unordered_map<std::string_view, HeavyHitter> combined;
+        combined.reserve(counters_.size() + other.counters_.size());
+        for (const auto &counter : counters_)
+            combined.emplace(counter.word, HeavyHitter{counter.word, counter.count + other_min, counter.error + other_min});
+
+        for (const auto &counter : other.counters_)
+        {
+            auto [it, inserted] = combined.try_emplace(counter.word, HeavyHitter{counter.word, counter.count + own_min, counter.error + own_min});
+            if (!inserted)
+            {
+                it->second.count += counter.count - other_min;
+                it->second.error += counter.error - other_min;
+            }
+        }
+
+        std::vector<HeavyHitter> merged;
+        merged.reserve(combined.size());
+        for (const auto &item : combined)
+            merged.push_back(item.second);
+
+        if (merged.size() > capacity_)
+        {
+            std::nth_element(merged.begin(), merged.begin() + capacity_, merged.end(), by_count);
+            merged.resize(capacity_);
+        }
+
+        const uint64_t total_count = total_count_ + other.total_count_;
+        rebuild(std::move(merged));
+        total_count_ = total_count;
+    }
+
+    // At most k monitored words by descending estimate, ties by word
+    std::vector<HeavyHitter> top(size_t k) const
+    {
+        std::vector<HeavyHitter> result = counters_;
+        k = std::min(k, result.size());
+        std::partial_sort(result.begin(), result.begin() + k, result.end(), by_count);
+        result.resize(k);
+        return result;
+    }
+
+    uint64_t total_count() const noexcept
+    {
+        return total_count_;
+    }
+
+    size_t capacity() const noexcept
+    {
+        return capacity_;
+    }
+
+    // Upper bound of the count of every unmonitored word and of the error of every counter
+    uint64_t max_error() const noexcept
+    {
+        return min_count();
+    }
+
+private:
+    static bool by_count(const HeavyHitter &a, const HeavyHitter &b) noexcept
+    {
+        return a.count != b.count ? a.count > b.count : a.word < b.word;
+    }
+
+    uint64_t min_count() const noexcept
+    {
+        return counters_.size() < capacity_ ? 0 : counters_[heap_[0]].count;
+    }
+
+    void rebuild(std::vector<HeavyHitter> counters)
+    {
+        counters_.clear();
+        heap_.clear();
+        heap_positions_.clear();
+        slots_.clear();
+        total_count_ = 0;
+
+        for (const auto &counter : counters)
+        {
+            add(counter.word, counter.count);
+            counters_.back().error = counter.error;
+        }
+    }
+
+    bool less(size_t a, size_t b) const noexcept
+    {
+        return counters_[heap_[a]].count < counters_[heap_[b]].count;
+    }
+
+    void swap_nodes(size_t a, size_t b) noexcept
+    {
+        std::swap(heap_[a], heap_[b]);
+        heap_positions_[heap_[a]] = a;
+        heap_positions_[heap_[b]] = b;
+    }
+
+    void sift_up(size_t node) noexcept
+    {
+        while (node > 0 && less(node, (node - 1) / 2))
+        {
+            swap_nodes(node, (node - 1) / 2);
+            node = (node - 1) / 2;
+        }
+    }
+
+    void sift_down(size_t node) noexcept
+    {
+        while (true)
+        {
+            size_t smallest = node;
+            for (size_t child = 2 * node + 1; child <= 2 * node + 2 && child < heap_.size(); ++child)
+            {
+                if (less(child, smallest))
+                    smallest = child;
+            }
+
+            if (smallest == node)
+                return;
+
+            swap_nodes(node, smallest);
+            node = smallest;
+        }
+    }
+
+    size_t capacity_;
+    uint64_t total_count_ = 0;
+    std::vector<HeavyHitter> counters_;
+    std::vector<size_t> heap_;           // min-heap of counter indexes by count
+    std::vector<size_t> heap_positions_; // of every counter in heap_
+    std::unordered_map<std::string_view, size_t> slots_;
+};
+
+// One sketch per block of words, merged in block order - the result does not depend on the scheduling
+template <typename ExecutionPolicy, typename RandomAccessIterator,
+    typename = std::enable_if_t<std::is_execution_policy_v<std::decay_t<ExecutionPolicy>>>>
+SpaceSaving heavy_hitters(ExecutionPolicy &&policy, RandomAccessIterator first, RandomAccessIterator last, size_t capacity, size_t block_size = 64 * 1024)
+{
+    const size_t size = std::distance(first, last);
+
+    std::vector<size_t> blocks((size + block_size - 1) / block_size);
+    std::iota(blocks.begin(), blocks.end(), size_t{0});
+
+    std::vector<SpaceSaving> sketches(blocks.size(), SpaceSaving{capacity});
+    std::for_each(policy, blocks.begin(), blocks.end(), [&](size_t block) {
+        auto block_first = first + block * block_size;
+        auto block_last = first + std::min(size, (block + 1) * block_size);
+        for (auto it = block_first; it != block_last; ++it)
+            sketches[block].add(std::string_view{*it});
+    });
+
+    SpaceSaving result{capacity};
+    for (const auto &sketch : sketches)
+        result.merge(sketch);
+    return result;
+}
+
+template <typename RandomAccessIterator>
+SpaceSaving heavy_hitters(RandomAccessIterator first, RandomAccessIterator last, size_t capacity)
+{
+    SpaceSaving sketch{capacity};
+    for (auto it = first; it != last; ++it)
+        sketch.add(std::string_view{*it});
+    return sketch;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+// x86 with GCC or Clang: kernels for newer instruction sets are compiled with target attributes
+// and chosen at run time with __builtin_cpu_supports
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define PSTL_HAS_AVX2_DISPATCH 1
+#endif
+
+// Index of the lowest set bit - bits must not be 0
+inline int count_trailing_zeros(uint64_t bits) noexcept
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+inline int count_ones(uint64_t bits) noexcept
+{
+    return static_cast<int>(std::bitset<64>(bits).count());
+}
@@ -0,0 +1,252 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <execution>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Variable-byte coding of ascending integers: gaps between neighbours are stored
+// in 7-bit groups, the high bit marks that another group follows
+namespace varbyte
+{
+    template <typename OutputIterator>
+    OutputIterator encode(uint32_t value, OutputIterator out)
+    {
+        while (value >= 0x80)
+        {
+            *out++ = static_cast<uint8_t>(value | 0x80);
+            value >>= 7;
+        }
+        *out++ = static_cast<uint8_t>(value);
+        return out;
+    }
+
+    inline uint32_t decode(const uint8_t *&in) noexcept
+    {
+        uint32_t value = 0;
+        for (int shift = 0;; shift += 7)
+        {
+            const uint8_t byte = *in++;
+            value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if (byte < 0x80)
+                return value;
+        }
+    }
+
+    template <typename InputIterator>
+    std::vector<uint8_t> encode_deltas(InputIterator first, InputIterator last)
+    {
+        std::vector<uint8_t> bytes;
+        uint32_t previous = 0;
+        for (; first != last; ++first)
+        {
+            encode(*first - previous, std::back_inserter(bytes));
+            previous = *first;
+        }
+        return bytes;
+    }
+
+    // Sequential reader of a delta-coded list
+    class DeltaCursor
+    {
+    public:
+        DeltaCursor(const uint8_t *data, size_t size) noexcept
+            : in_{data}, remaining_{size}
+        {
+        }
+
+        bool done() const noexcept
+        {
+            return remaining_ == 0;
+        }
+
+        uint32_t next() noexcept
+        {
+            --remaining_;
+            value_ += decode(in_);
+            return value_;
+        }
+
+    private:
+        const uint8_t *in_;
+        size_t remaining_;
+        uint32_t value_ = 0;
+    };
+} // namespace varbyte
+
+// Word -> ascending positions in the indexed range, posting lists are delta + variable-byte coded.
+// Terms are views into the indexed words, which have to outlive the index.
+class InvertedIndex
+{
+public:
+    template <typename ExecutionPolicy, typename RandomAccessIterator,
+        typename = std::enable_if_t<std::is_execution_policy_v<std::decay_t<ExecutionPolicy>>>>
+    InvertedIndex(ExecutionPolicy &&policy, RandomAccessIterator first, RandomAccessIterator last)
+    {
+        const size_t size = std::distance(first, last);
+        if (size > std::numeric_limits<uint32_t>::max())
+            throw std::length_error("InvertedIndex: too many words");
+
+        // (word, position) pairs sorted once - every run of a word is its posting list
+        std::vector<std::pair<std::string_view, uint32_t>> occurrences(size);
+        std::vector<uint32_t> positions(size);
+        std::iota(positions.begin(), positions.end(), uint32_t{0});
+        std::transform(policy, positions.begin(), positions.end(), occurrences.begin(), [&](uint32_t position) {
+            return std::pair{std::string_view{first[position]}, position};
+        });
+        std::sort(policy, occurrences.begin(), occurrences.end());
+
+        std::vector<size_t> run_starts;
+        for (size_t i = 0; i < size; ++i)
+        {
+            if (i == 0 || occurrences[i].first != occurrences[i - 1].first)
+                run_starts.push_back(i);
+        }
+        run_starts.push_back(size);
+
+        const size_t no_of_terms = run_starts.size() - 1;
+        terms_.resize(no_of_terms);
+        list_sizes_.resize(no_of_terms);
+
+        std::vector<std::vector<uint8_t>> lists(no_of_terms);
+        std::vector<size_t> term_indexes(no_of_terms);
+        std::iota(term_indexes.begin(), term_indexes.end(), size_t{0});
+
+        std::for_each(policy, term_indexes.begin(), term_indexes.end(), [&](size_t term) {
+            auto run_first = occurrences.begin() + run_starts[term];
+            auto run_last = occurrences.begin() + run_starts[term + 1];
+
+            terms_[term] = run_first->first;
+            list_sizes_[term] = static_cast<uint32_t>(run_last - run_first);
+
+            std::vector<uint32_t> run_positions(run_last - run_first);
+            std::transform(run_first, run_last, run_positions.begin(), [](const auto &occurrence) { return occurrence.second; });
+            lists[term] = varbyte::encode_deltas(run_positions.begin(), run_positions.end());
+        });
+
+        offsets_.resize(no_of_terms + 1);
+        std::transform_inclusive_scan(lists.begin(), lists.end(), offsets_.begin() + 1, std::plus{}, [](const auto &list) { return list.size(); });
+
+        postings_.resize(offsets_.back());
+        std::for_each(policy, term_indexes.begin(), term_indexes.end(), [&](size_t term) {
+            std::copy(lists[term].begin(), lists[term].end(), postings_.begin() + offsets_[term]);
+        });
+    }
+
+    template <typename RandomAccessIterator>
+    InvertedIndex(RandomAccessIterator first, RandomAccessIterator last)
+        : InvertedIndex(std::execution::seq, first, last)
+    {
+    }
+
+    size_t no_of_terms() const noexcept
+    {
+        return terms_.size();
+    }
+
+    // Size of the coded posting lists
+    size_t no_of_bytes() const noexcept
+    {
+        return postings_.size();
+    }
+
+    size_t frequency(std::string_view word) const noexcept
+    {
+        const auto term = find(word);
+        return term ? list_sizes_[*term] : 0;
+    }
+
+    std::vector<uint32_t> positions(std::string_view word) const
+    {
+        std::vector<uint32_t> result;
+        if (const auto term = find(word))
+        {
+            result.reserve(list_sizes_[*term]);
+            for (auto cursor = cursor_of(*term); !cursor.done();)
+                result.push_back(cursor.next());
+        }
+        return result;
+    }
+
+    // Start positions of the words appearing one after another - the posting lists (shifted by the
+    // offset of their word in the phrase) are intersected, starting with the shortest one
+    std::vector<uint32_t> phrase(const std::vector<std::string_view> &phrase_words) const
+    {
+        std::vector<std::pair<size_t, uint32_t>> lists; // term, offset in the phrase
+        for (uint32_t offset = 0; offset < phrase_words.size(); ++offset)
+        {
+            const auto term = find(phrase_words[offset]);
+            if (!term)
+                return {};
+            lists.emplace_back(*term, offset);
+        }
+
+        if (lists.empty())
+            return {};
+
+        std::sort(lists.begin(), lists.end(), [&](const auto &a, const auto &b) { return list_sizes_[a.first] < list_sizes_[b.first]; });
+
+        std::vector<uint32_t> candidates;
+        candidates.reserve(list_sizes_[lists.front().first]);
+        for (auto cursor = cursor_of(lists.front().first); !cursor.done();)
+        {
+            const uint32_t position = cursor.next();
+            if (position >= lists.front().second)
+                candidates.push_back(position - lists.front().second);
+        }
+
+        for (auto it = std::next(lists.begin()); it != lists.end() && !candidates.empty(); ++it)
+            candidates = intersect(candidates, it->first, it->second);
+
+        return candidates;
+    }
+
+private:
+    std::optional<size_t> find(std::string_view word) const noexcept
+    {
+        const auto it = std::lower_bound(terms_.begin(), terms_.end(), word);
+        if (it == terms_.end() || *it != word)
+            return std::nullopt;
+        return static_cast<size_t>(it - terms_.begin());
+    }
+
+    varbyte::DeltaCursor cursor_of(size_t term) const noexcept
+    {
+        return varbyte::DeltaCursor{postings_.data() + offsets_[term], list_sizes_[term]};
+    }
+
+    // Candidates c for which c + offset is in the posting list of the term
+    std::vector<uint32_t> intersect(const std::vector<uint32_t> &candidates, size_t term, uint32_t offset) const
+    {
+        std::vector<uint32_t> result;
+        auto cursor = cursor_of(term);
+        auto candidate = candidates.begin();
+
+        while (!cursor.done() && candidate != candidates.end())
+        {
+            const uint32_t position = cursor.next();
+            if (position < offset)
+                continue;
+
+            const uint32_t start = position - offset;
+            candidate = std::lower_bound(candidate, candidates.end(), start);
+            if (candidate != candidates.end() && *candidate == start)
+                result.push_back(*candidate++);
+        }
+
+        return result;
+    }
+
+    std::vector<std::string_view> terms_; // sorted
+    std::vector<uint32_t> list_sizes_;
+    std::vector<size_t> offsets_; // of the posting list of every term in postings_
+    std::vector<uint8_t> postings_;
+};
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <vector>
+
+// HDR-style histogram of durations in nanoseconds: values below 128 are counted exactly,
+// above that every power of two is split into 64 linear sub-buckets (relative error < 1.6%)
+class LatencyHistogram
+{
+public:
+    static constexpr int sub_bucket_bits = 7;
+    static constexpr uint64_t sub_bucket_count = uint64_t{1} << sub_bucket_bits;
+    static constexpr uint64_t sub_bucket_half = sub_bucket_count / 2;
+    static constexpr size_t no_of_buckets = (64 - sub_bucket_bits + 2) * sub_bucket_half;
+
+    LatencyHistogram()
+        : counts_(no_of_buckets)
+    {
+    }
+
+    void record(uint64_t value_ns, uint64_t count = 1) noexcept
+    {
+        counts_[bucket_index(value_ns)] += count;
+        total_count_ += count;
+        min_ = std::min(min_, value_ns);
+        max_ = std::max(max_, value_ns);
+        sum_ += static_cast<double>(value_ns) * count;
+    }
+
+    void merge(const LatencyHistogram &other) noexcept
+    {
+        for (size_t i = 0; i < counts_.size(); ++i)
+            counts_[i] += other.counts_[i];
+        total_count_ += other.total_count_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+        sum_ += other.sum_;
+    }
+
+    uint64_t count() const noexcept
+    {
+        return total_count_;
+    }
+
+    uint64_t min() const noexcept
+    {
+        return total_count_ ? min_ : 0;
+    }
+
+    uint64_t max() const noexcept
+    {
+        return max_;
+    }
+
+    double mean() const noexcept
+    {
+        return total_count_ ? sum_ / total_count_ : 0.0;
+    }
+
+    // Highest value equivalent to the sample at the given percentile (0 - 100), capped by max()
+    uint64_t percentile(double percentile) const noexcept
+    {
+        if (total_count_ == 0)
+            return 0;
+
+        const double clamped = std::clamp(percentile, 0.0, 100.0);
+        const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(clamped / 100.0 * total_count_ + 0.5));
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts_.size(); ++i)
+        {
+            seen += counts_[i];
+            if (seen >= rank)
+                return std::min(bucket_upper_bound(i), max_);
+        }
+
+        return max_;
+    }
+
+    // Non-empty buckets as "lower_ns,upper_ns,count" rows
+    void write_csv(std::ostream &out) const
+    {
+        out << "lower_ns,upper_ns,count\n";
+        for (size_t i = 0; i < counts_.size(); ++i)
+        {
+            if (counts_[i])
+                out << bucket_lower_bound(i) << ',' << bucket_upper_bound(i) << ',' << counts_[i] << '\n';
+        }
+    }
+
+    static size_t bucket_index(uint64_t value) noexcept
+    {
+        if (value < sub_bucket_count)
+            return static_cast<size_t>(value);
+
+        int shift = highest_bit(value) - (sub_bucket_bits - 1);
+        return static_cast<size_t>((shift + 1) * sub_bucket_half + ((value >> shift) - sub_bucket_half));
+    }
+
+    static uint64_t bucket_lower_bound(size_t index) noexcept
+    {
+        if (index < sub_bucket_count)
+            return index;
+
+        const int shift = static_cast<int>(index / sub_bucket_half) - 1;
+        return (index % sub_bucket_half + sub_bucket_half) << shift;
+    }
+
+    static uint64_t bucket_upper_bound(size_t index) noexcept
+    {
+        if (index < sub_bucket_count)
+            return index;
+
+        const int shift = static_cast<int>(index / sub_bucket_half) - 1;
+        return bucket_lower_bound(index) + ((uint64_t{1} << shift) - 1);
+    }
+
+private:
+    static int highest_bit(uint64_t value) noexcept
+    {
+        int bit = 63;
+        while (bit > 0 && ((value >> bit) & 1) == 0)
+            --bit;
+        return bit;
+    }
+
+    std::vector<uint64_t> counts_;
+    uint64_t total_count_ = 0;
+    uint64_t min_ = std::numeric_limits<uint64_t>::max();
+    uint64_t max_ = 0;
+    double sum_ = 0;
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <vector>
+
+// Tournament tree for k-way merging: every inner node keeps the loser of its match, so
+// replacing the winner replays only the log2(k) matches on its path to the root.
+// Ties go to the lower source, which keeps the merge stable.
+template <typename T, typename Compare = std::less<>>
+class LoserTree
+{
+public:
+    // heads[i] - first value of source i, std::nullopt for an empty source
+    explicit LoserTree(std::vector<std::optional<T>> heads, Compare comp = Compare{})
+        : comp_{std::move(comp)}
+    {
+        no_of_leaves_ = 1;
+        while (no_of_leaves_ < heads.size())
+            no_of_leaves_ *= 2;
+
+        values_.resize(no_of_leaves_);
+        exhausted_.assign(no_of_leaves_, true);
+        for (size_t i = 0; i < heads.size(); ++i)
+        {
+            if (heads[i])
+            {
+                values_[i] = std::move(*heads[i]);
+                exhausted_[i] = false;
+            }
+        }
+
+        std::vector<size_t> winners(2 * no_of_leaves_);
+        for (size_t i = 0; i < no_of_leaves_; ++i)
+            winners[no_of_leaves_ + i] = i;
+
+        nodes_.resize(no_of_leaves_);
+        for (size_t node = no_of_leaves_ - 1; node >= 1; --node)
+        {
+            size_t winner = winners[2 * node];
+            size_t loser = winners[2 * node + 1];
+            if (beats(loser, winner))
+                std::swap(winner, loser);
+
+            winners[node] = winner;
+            nodes_[node] = loser;
+        }
+        nodes_[0] = winners[1];
+    }
+
+    bool empty() const noexcept
+    {
+        return exhausted_[nodes_[0]];
+    }
+
+    // Source of the smallest value
+    size_t top_source() const noexcept
+    {
+        return nodes_[0];
+    }
+
+    const T &top() const noexcept
+    {
+        return values_[nodes_[0]];
+    }
+
+    // Next value of top_source(), std::nullopt when the source is exhausted
+    void replace_top(std::optional<T> next)
+    {
+        size_t winner = nodes_[0];
+        if (next)
+            values_[winner] = std::move(*next);
+        else
+            exhausted_[winner] = true;
+
+        for (size_t node = (no_of_leaves_ + winner) / 2; node >= 1; node /= 2)
+        {
+            if (beats(nodes_[node], winner))
+                std::swap(nodes_[node], winner);
+        }
+        nodes_[0] = winner;
+    }
+
+private:
+    bool beats(size_t a, size_t b) const
+    {
+        if (exhausted_[a] || exhausted_[b])
+            return !exhausted_[a] && exhausted_[b];
+        if (comp_(values_[a], values_[b]))
+            return true;
+        if (comp_(values_[b], values_[a]))
+            return false;
+        return a < b;
+    }
+
+    Compare comp_;
+    size_t no_of_leaves_;
+    std::vector<T> values_;
+    std::vector<bool> exhausted_;
+    std::vector<size_t> nodes_; // nodes_[0] - overall winner, nodes_[1..] - losers of the matches
+};
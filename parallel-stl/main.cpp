@@ -1,4 +1,62 @@
-#define CATCH_CONFIG_MAIN
+#define CATCH_CONFIG_RUNNER
 #define CATCH_CONFIG_ENABLE_BENCHMARKING
 
-#include "catch.hpp"
\ No newline at end of file
+#include "benchmark_options.hpp"
+#include "catch.hpp"
+#include "measurement.hpp"
+#include "tracing.hpp"
+
+#include <cstdio>
+
+CATCH_REGISTER_LISTENER(MeasurementListener)
+
+int main(int argc, char *argv[])
+{
+    Catch::Session session;
+    BenchmarkOptions &options = benchmark_options();
+
+    std::string sizes;
+    std::string threads;
+
+    using namespace Catch::clara;
+    auto cli = session.cli()
+        | Opt(sizes, "n1,n2,...")["--sizes"]("data sizes of the scaling sweep [PSTL_SIZES]")
+        | Opt(threads, "t1,t2,...")["--threads"]("thread counts of the scaling sweep [PSTL_THREADS]")
+        | Opt(options.repetitions, "count")["--repetitions"]("runs per point of the scaling sweep [PSTL_REPETITIONS]")
+        | Opt(options.scaling_output, "file")["--scaling-output"]("scaling table as .csv or .json [PSTL_SCALING_OUTPUT]")
+        | Opt(options.perf_counters)["--perf-counters"]("report hardware counters of every benchmark [PSTL_PERF_COUNTERS]")
+        | Opt(options.histograms)["--histograms"]("report latency percentiles of every benchmark [PSTL_HISTOGRAMS]")
+        | Opt(options.histogram_directory, "directory")["--histogram-dir"]("export latency histograms as CSV files [PSTL_HISTOGRAM_DIR]")
+        | Opt(options.trace_output, "file")["--trace"]("record tracing zones as Chrome trace JSON [PSTL_TRACE]")
+        | Opt(options.corpus_file, "file")["--corpus-file"]("output of the [corpus] test case [PSTL_CORPUS_FILE]")
+        | Opt(options.corpus_bytes, "bytes")["--corpus-bytes"]("size of the generated corpus file [PSTL_CORPUS_BYTES]")
+        | Opt(options.external_sort_input, "file")["--external-sort-input"]("input of the external sort benchmarks [PSTL_EXTERNAL_SORT_INPUT]")
+        | Opt(options.external_sort_run_bytes, "bytes")["--external-sort-run-bytes"]("memory for one sorted run [PSTL_EXTERNAL_SORT_RUN_BYTES]")
+        | Opt(options.arena_report)["--arena-report"]("report the allocations of the arenas [PSTL_ARENA_REPORT]");
+
+    session.cli(cli);
+
+    if (int result = session.applyCommandLine(argc, argv); result != 0)
+        return result;
+
+    if (!sizes.empty())
+        options.sizes = BenchmarkOptions::parse_list(sizes);
+    if (!threads.empty())
+        options.threads = BenchmarkOptions::parse_list(threads);
+    if (options.perf_counters)
+        PerfCounters::instance().enable();
+    if (options.histograms || !options.histogram_directory.empty())
+        Measurements::instance().enable_histograms(options.histogram_directory);
+    if (!options.trace_output.empty())
+        trace::enable();
+
+    const int result = session.run();
+
+    if (!options.trace_output.empty() && !trace::write_chrome_trace(options.trace_output))
+    {
+        std::fprintf(stderr, "cannot write trace to %s\n", options.trace_output.c_str());
+        return 1;
+    }
+
+    return result;
+}
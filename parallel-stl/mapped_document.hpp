@@ -0,0 +1,81 @@
+#pragma once
+
+#include "mapped_file.hpp"
+#include "tokenizer.hpp"
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Words of a mapped file - every word is a view into the mapping owned by the document
+class MappedDocumentContent
+{
+public:
+    using value_type = std::string_view;
+    using const_iterator = std::vector<std::string_view>::const_iterator;
+
+    MappedDocumentContent(MappedFile file, std::vector<std::string_view> words)
+        : file_{std::move(file)}, words_{std::move(words)}
+    {
+    }
+
+    const std::vector<std::string_view> &words() const noexcept
+    {
+        return words_;
+    }
+
+    std::string_view text() const noexcept
+    {
+        return file_.content();
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return words_.begin();
+    }
+
+    const_iterator end() const noexcept
+    {
+        return words_.end();
+    }
+
+    size_t size() const noexcept
+    {
+        return words_.size();
+    }
+
+    std::string_view operator[](size_t index) const noexcept
+    {
+        return words_[index];
+    }
+
+private:
+    MappedFile file_;
+    std::vector<std::string_view> words_;
+};
+
+inline std::optional<MappedDocumentContent> load_words_mapped(const std::string &file_name)
+{
+    auto file = MappedFile::open(file_name);
+
+    if (!file)
+        return std::nullopt;
+
+    auto words = tokenize(file->content());
+
+    return MappedDocumentContent{std::move(*file), std::move(words)};
+}
+
+template <typename ExecutionPolicy>
+std::optional<MappedDocumentContent> load_words_mapped(ExecutionPolicy &&policy, const std::string &file_name)
+{
+    auto file = MappedFile::open(file_name);
+
+    if (!file)
+        return std::nullopt;
+
+    auto words = tokenize(std::forward<ExecutionPolicy>(policy), file->content());
+
+    return MappedDocumentContent{std::move(*file), std::move(words)};
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define PSTL_HAS_MMAP 1
+#else
+#include <fstream>
+#include <vector>
+#endif
+
+// Read-only view of a whole file. On POSIX systems the file is memory-mapped,
+// elsewhere its content is read once into a buffer that never moves.
+class MappedFile
+{
+public:
+    static std::optional<MappedFile> open(const std::string &file_name)
+    {
+#ifdef PSTL_HAS_MMAP
+        int fd = ::open(file_name.c_str(), O_RDONLY);
+        if (fd == -1)
+            return std::nullopt;
+
+        struct stat file_stat;
+        if (::fstat(fd, &file_stat) == -1)
+        {
+            ::close(fd);
+            return std::nullopt;
+        }
+
+        MappedFile file;
+        file.size_ = static_cast<size_t>(file_stat.st_size);
+
+        if (file.size_ > 0)
+        {
+            void *address = ::mmap(nullptr, file.size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (address == MAP_FAILED)
+            {
+                ::close(fd);
+                return std::nullopt;
+            }
+            ::madvise(address, file.size_, MADV_SEQUENTIAL);
+            file.data_ = static_cast<const char *>(address);
+        }
+
+        ::close(fd);
+        return file;
+#else
+        std::ifstream input_file{file_name, std::ios::binary | std::ios::ate};
+        if (!input_file)
+            return std::nullopt;
+
+        MappedFile file;
+        file.buffer_.resize(static_cast<size_t>(input_file.tellg()));
+        input_file.seekg(0);
+        if (!input_file.read(file.buffer_.data(), file.buffer_.size()))
+            return std::nullopt;
+
+        file.data_ = file.buffer_.data();
+        file.size_ = file.buffer_.size();
+        return file;
+#endif
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    MappedFile(MappedFile &&other) noexcept
+        : data_{std::exchange(other.data_, nullptr)}, size_{std::exchange(other.size_, 0)}
+#ifndef PSTL_HAS_MMAP
+        , buffer_{std::move(other.buffer_)}
+#endif
+    {
+    }
+
+    MappedFile &operator=(MappedFile &&other) noexcept
+    {
+        if (this != &other)
+        {
+            unmap();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+#ifndef PSTL_HAS_MMAP
+            buffer_ = std::move(other.buffer_);
+#endif
+        }
+        return *this;
+    }
+
+    ~MappedFile()
+    {
+        unmap();
+    }
+
+    std::string_view content() const noexcept
+    {
+        return {data_, size_};
+    }
+
+    size_t size() const noexcept
+    {
+        return size_;
+    }
+
+private:
+    MappedFile() = default;
+
+    void unmap() noexcept
+    {
+#ifdef PSTL_HAS_MMAP
+        if (data_)
+            ::munmap(const_cast<char *>(data_), size_);
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+#ifndef PSTL_HAS_MMAP
+    std::vector<char> buffer_;
+#endif
+};
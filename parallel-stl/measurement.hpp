@@ -0,0 +1,297 @@
+#pragma once
+
+#include "catch.hpp"
+#include "latency_histogram.hpp"
+#include "perf_counters.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Counters and durations collected for one BENCHMARK - only calls of the measured samples
+// are included, the warm-up that Catch runs before benchmarkStarting is skipped
+struct BenchmarkMeasurement
+{
+    explicit BenchmarkMeasurement(std::string name)
+        : name{std::move(name)}
+    {
+    }
+
+    std::string name;
+    size_t calls = 0;
+    double elements = 0; // summed over all calls
+    bool counted = false;
+    PerfSnapshot counters;
+    LatencyHistogram latencies;
+};
+
+class Measurements
+{
+public:
+    static Measurements &instance()
+    {
+        static Measurements measurements;
+        return measurements;
+    }
+
+    // An empty directory keeps the histograms in the report only
+    void enable_histograms(const std::string &export_directory)
+    {
+        histograms_enabled_ = true;
+        histogram_directory_ = export_directory;
+    }
+
+    void disable_histograms()
+    {
+        histograms_enabled_ = false;
+        histogram_directory_.clear();
+    }
+
+    bool histograms_enabled() const noexcept
+    {
+        return histograms_enabled_;
+    }
+
+    const std::string &histogram_directory() const noexcept
+    {
+        return histogram_directory_;
+    }
+
+    bool enabled() const noexcept
+    {
+        return histograms_enabled_ || PerfCounters::instance().enabled();
+    }
+
+    void start_benchmark(const std::string &name)
+    {
+        benchmarks_.push_back(BenchmarkMeasurement{name});
+        current_ = &benchmarks_.back();
+    }
+
+    void stop_benchmark()
+    {
+        current_ = nullptr;
+    }
+
+    BenchmarkMeasurement *current() noexcept
+    {
+        return current_;
+    }
+
+    std::vector<BenchmarkMeasurement> take_benchmarks()
+    {
+        current_ = nullptr;
+        return std::move(benchmarks_);
+    }
+
+private:
+    std::vector<BenchmarkMeasurement> benchmarks_;
+    BenchmarkMeasurement *current_ = nullptr;
+    bool histograms_enabled_ = false;
+    std::string histogram_directory_;
+};
+
+// Put around meter.measure, outside of the timed region - BenchmarkGroup::run does. Counts hardware
+// events of all threads (opt-in: --perf-counters) while the scope is alive. With --histograms the calls
+// inside meter.measure go through time_call, which records the duration of every call on its own.
+class MeasurementScope
+{
+public:
+    explicit MeasurementScope(size_t elements_per_call, size_t calls = 1)
+        : elements_per_call_{elements_per_call}, calls_{std::max<size_t>(calls, 1)}
+    {
+        Measurements &measurements = Measurements::instance();
+        if (!measurements.enabled() || !measurements.current())
+            return;
+
+        active_ = true;
+        benchmark_ = measurements.current();
+        counting_ = PerfCounters::instance().enabled();
+        if (counting_)
+            counters_start_ = PerfCounters::instance().snapshot();
+    }
+
+    MeasurementScope(const MeasurementScope &) = delete;
+    MeasurementScope &operator=(const MeasurementScope &) = delete;
+
+    bool times_calls() const noexcept
+    {
+        return active_ && Measurements::instance().histograms_enabled();
+    }
+
+    // Runs call and records its duration in the latency histogram. It is called inside the timed
+    // region, so the two clock reads add to the measured time - use it only if times_calls().
+    template <typename Call>
+    void time_call(Call &&call)
+    {
+        if (!times_calls())
+        {
+            call();
+            return;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        call();
+        const auto duration = std::chrono::steady_clock::now() - start;
+        benchmark_->latencies.record(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+    }
+
+    ~MeasurementScope()
+    {
+        if (!active_)
+            return;
+
+        benchmark_->calls += calls_;
+        benchmark_->elements += static_cast<double>(elements_per_call_) * calls_;
+
+        if (counting_)
+        {
+            benchmark_->counted = true;
+            const PerfSnapshot counters_stop = PerfCounters::instance().snapshot();
+            for (size_t i = 0; i < no_of_perf_events; ++i)
+                benchmark_->counters.values[i] += counters_stop.values[i] - counters_start_.values[i];
+        }
+    }
+
+private:
+    size_t elements_per_call_;
+    size_t calls_;
+    bool active_ = false;
+    bool counting_ = false;
+    BenchmarkMeasurement *benchmark_ = nullptr;
+    PerfSnapshot counters_start_;
+};
+
+// Prints counters and latency percentiles of all benchmarks of a test case after Catch's own report of it -
+// a latency is the duration of one call
+class MeasurementListener : public Catch::TestEventListenerBase
+{
+public:
+    using TestEventListenerBase::TestEventListenerBase;
+
+    void benchmarkStarting(Catch::BenchmarkInfo const &info) override
+    {
+        if (Measurements::instance().enabled())
+            Measurements::instance().start_benchmark(info.name);
+    }
+
+    void benchmarkEnded(Catch::BenchmarkStats<> const &) override
+    {
+        Measurements::instance().stop_benchmark();
+    }
+
+    void testCaseEnded(Catch::TestCaseStats const &stats) override
+    {
+        auto benchmarks = Measurements::instance().take_benchmarks();
+        if (benchmarks.empty())
+            return;
+
+        if (std::any_of(benchmarks.begin(), benchmarks.end(), [](const auto &benchmark) { return benchmark.counted; }))
+            report_counters(stats.testInfo.name, benchmarks);
+
+        if (Measurements::instance().histograms_enabled())
+        {
+            report_latencies(stats.testInfo.name, benchmarks);
+            export_histograms(stats.testInfo.name, benchmarks);
+        }
+    }
+
+private:
+    static void report_counters(const std::string &test_case, const std::vector<BenchmarkMeasurement> &benchmarks)
+    {
+        const PerfCounters &counters = PerfCounters::instance();
+        std::printf("\nHardware counters - %s\n", test_case.c_str());
+
+        if (!counters.any_available())
+        {
+            std::printf("  unavailable (%s)\n", counters.unavailable_reason().c_str());
+            return;
+        }
+
+        std::printf("  %-48s %8s %12s %12s %12s %12s %12s\n", "benchmark", "IPC", "cycles/el", "instr/el", "L1D miss/el", "LLC miss/el", "br miss/el");
+        for (const auto &benchmark : benchmarks)
+        {
+            if (benchmark.calls == 0 || !benchmark.counted)
+                continue;
+
+            auto value = [&](PerfEvent event) { return benchmark.counters.values[static_cast<size_t>(event)]; };
+            auto per_element = [&](PerfEvent event) {
+                return counters.available(event) && benchmark.elements > 0 ? format(value(event) / benchmark.elements) : std::string("n/a");
+            };
+            const bool has_ipc = counters.available(PerfEvent::cycles) && counters.available(PerfEvent::instructions) && value(PerfEvent::cycles) > 0;
+
+            std::printf("  %-48s %8s %12s %12s %12s %12s %12s\n", benchmark.name.substr(0, 48).c_str(),
+                has_ipc ? format(value(PerfEvent::instructions) / value(PerfEvent::cycles)).c_str() : "n/a",
+                per_element(PerfEvent::cycles).c_str(), per_element(PerfEvent::instructions).c_str(), per_element(PerfEvent::l1d_misses).c_str(),
+                per_element(PerfEvent::llc_misses).c_str(), per_element(PerfEvent::branch_misses).c_str());
+        }
+    }
+
+    static void report_latencies(const std::string &test_case, const std::vector<BenchmarkMeasurement> &benchmarks)
+    {
+        std::printf("\nLatency percentiles - %s\n", test_case.c_str());
+        std::printf("  %-48s %8s %10s %10s %10s %10s %10s\n", "benchmark", "calls", "p50", "p90", "p99", "p99.9", "max");
+
+        for (const auto &benchmark : benchmarks)
+        {
+            const auto &latencies = benchmark.latencies;
+            std::printf("  %-48s %8llu %10s %10s %10s %10s %10s\n", benchmark.name.substr(0, 48).c_str(), static_cast<unsigned long long>(latencies.count()),
+                format_duration(latencies.percentile(50)).c_str(), format_duration(latencies.percentile(90)).c_str(),
+                format_duration(latencies.percentile(99)).c_str(), format_duration(latencies.percentile(99.9)).c_str(),
+                format_duration(latencies.max()).c_str());
+        }
+    }
+
+    static void export_histograms(const std::string &test_case, const std::vector<BenchmarkMeasurement> &benchmarks)
+    {
+        const std::string &directory = Measurements::instance().histogram_directory();
+        if (directory.empty())
+            return;
+
+        for (const auto &benchmark : benchmarks)
+        {
+            const std::string file_name = directory + "/" + file_name_part(test_case) + "." + file_name_part(benchmark.name) + ".csv";
+            std::ofstream out{file_name};
+            if (!out)
+            {
+                std::printf("  cannot write %s\n", file_name.c_str());
+                continue;
+            }
+            benchmark.latencies.write_csv(out);
+        }
+    }
+
+    static std::string file_name_part(std::string text)
+    {
+        for (char &c : text)
+        {
+            if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_')
+                c = '_';
+        }
+        return text;
+    }
+
+    static std::string format(double value)
+    {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.3g", value);
+        return buffer;
+    }
+
+    static std::string format_duration(uint64_t ns)
+    {
+        char buffer[32];
+        if (ns < 10'000)
+            std::snprintf(buffer, sizeof(buffer), "%llu ns", static_cast<unsigned long long>(ns));
+        else if (ns < 10'000'000)
+            std::snprintf(buffer, sizeof(buffer), "%.1f us", ns / 1e3);
+        else
+            std::snprintf(buffer, sizeof(buffer), "%.2f ms", ns / 1e6);
+        return buffer;
+    }
+};
@@ -0,0 +1,308 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <execution>
+#include <iterator>
+#include <numeric>
+#include <vector>
+
+#include "mul_high.hpp"
+
+namespace miller_rabin_detail
+{
+    // Arithmetic modulo an odd n on numbers in Montgomery form (x * 2^64 mod n)
+    class Montgomery
+    {
+    public:
+        explicit Montgomery(uint64_t n) noexcept
+            : n_{n}, n_inv_{inverse(n)}, one_{(0 - n) % n}, r2_{square_mod(one_, n)}
+        {
+        }
+
+        uint64_t multiply(uint64_t a, uint64_t b) const noexcept
+        {
+            const uint64_t low = a * b;
+            const uint64_t high = mul_high(a, b);
+            const uint64_t m_high = mul_high(low * n_inv_, n_);
+            return high >= m_high ? high - m_high : high - m_high + n_;
+        }
+
+        uint64_t to_montgomery(uint64_t a) const noexcept
+        {
+            return multiply(a % n_, r2_);
+        }
+
+        uint64_t power(uint64_t base, uint64_t exponent) const noexcept
+        {
+            uint64_t result = one_;
+            for (; exponent != 0; exponent >>= 1)
+            {
+                if (exponent & 1)
+                    result = multiply(result, base);
+                base = multiply(base, base);
+            }
+            return result;
+        }
+
+        uint64_t modulus() const noexcept
+        {
+            return n_;
+        }
+
+        uint64_t one() const noexcept
+        {
+            return one_;
+        }
+
+        uint64_t minus_one() const noexcept
+        {
+            return n_ - one_;
+        }
+
+    private:
+        static uint64_t inverse(uint64_t n) noexcept
+        {
+            uint64_t inv = n; // correct to 3 bits for odd n - each step doubles that
+            for (int i = 0; i < 5; ++i)
+                inv *= 2 - n * inv;
+            return inv;
+        }
+
+        static uint64_t square_mod(uint64_t a, uint64_t n) noexcept
+        {
+#if defined(_MSC_VER) && !defined(__clang__)
+            uint64_t high;
+            uint64_t low = _umul128(a, a, &high);
+            uint64_t remainder;
+            _udiv128(high, low, n, &remainder);
+            return remainder;
+#else
+            return static_cast<uint64_t>((static_cast<unsigned __int128>(a) * a) % n);
+#endif
+        }
+
+        uint64_t n_;
+        uint64_t n_inv_;
+        uint64_t one_;
+        uint64_t r2_;
+    };
+
+    // Bases proven to give a deterministic test for every n < 2^64 (Jim Sinclair)
+    constexpr std::array<uint64_t, 7> bases = {2, 325, 9375, 28178, 450775, 9780504, 1795265022};
+
+    constexpr std::array<uint64_t, 12> small_primes = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+
+    enum class Screening
+    {
+        prime,
+        composite,
+        undecided
+    };
+
+    inline Screening screen(uint64_t n) noexcept
+    {
+        if (n < 2)
+            return Screening::composite;
+
+        for (uint64_t p : small_primes)
+        {
+            if (n == p)
+                return Screening::prime;
+            if (n % p == 0)
+                return Screening::composite;
+        }
+
+        return n < 41 * 41 ? Screening::prime : Screening::undecided;
+    }
+
+    inline int count_trailing_zeros(uint64_t n) noexcept
+    {
+        int count = 0;
+        for (; (n & 1) == 0; n >>= 1)
+            ++count;
+        return count;
+    }
+
+    inline bool is_strong_probable_prime(const Montgomery &mont, uint64_t n, uint64_t base) noexcept
+    {
+        base %= n;
+        if (base == 0)
+            return true;
+
+        const int s = count_trailing_zeros(n - 1);
+        uint64_t x = mont.power(mont.to_montgomery(base), (n - 1) >> s);
+
+        if (x == mont.one() || x == mont.minus_one())
+            return true;
+
+        for (int r = 1; r < s; ++r)
+        {
+            x = mont.multiply(x, x);
+            if (x == mont.minus_one())
+                return true;
+        }
+
+        return false;
+    }
+
+    constexpr size_t no_of_lanes = 4;
+    constexpr size_t batch_size = 256;
+
+    // One strong probable prime round for no_of_lanes candidates in lockstep - independent
+    // multiplication chains keep the multiplier busy while each chain waits for its latency
+    inline std::array<bool, no_of_lanes> are_strong_probable_primes(const std::array<const Montgomery *, no_of_lanes> &mont, uint64_t base) noexcept
+    {
+        std::array<uint64_t, no_of_lanes> a, x, d;
+        std::array<int, no_of_lanes> s;
+        std::array<bool, no_of_lanes> passed;
+        uint64_t all_exponent_bits = 0;
+        int max_s = 0;
+
+        for (size_t lane = 0; lane < no_of_lanes; ++lane)
+        {
+            const uint64_t n = mont[lane]->modulus();
+            s[lane] = count_trailing_zeros(n - 1);
+            d[lane] = (n - 1) >> s[lane];
+            a[lane] = mont[lane]->to_montgomery(base);
+            x[lane] = mont[lane]->one();
+            passed[lane] = base % n == 0;
+            all_exponent_bits |= d[lane];
+            max_s = std::max(max_s, s[lane]);
+        }
+
+        int top_bit = 63;
+        while (top_bit > 0 && ((all_exponent_bits >> top_bit) & 1) == 0)
+            --top_bit;
+
+        for (int bit = top_bit; bit >= 0; --bit)
+        {
+            for (size_t lane = 0; lane < no_of_lanes; ++lane)
+            {
+                const uint64_t squared = mont[lane]->multiply(x[lane], x[lane]);
+                const uint64_t multiplied = mont[lane]->multiply(squared, a[lane]);
+                x[lane] = ((d[lane] >> bit) & 1) ? multiplied : squared;
+            }
+        }
+
+        for (size_t lane = 0; lane < no_of_lanes; ++lane)
+            passed[lane] = passed[lane] || x[lane] == mont[lane]->one() || x[lane] == mont[lane]->minus_one();
+
+        for (int r = 1; r < max_s; ++r)
+        {
+            for (size_t lane = 0; lane < no_of_lanes; ++lane)
+            {
+                if (!passed[lane] && r < s[lane])
+                {
+                    x[lane] = mont[lane]->multiply(x[lane], x[lane]);
+                    passed[lane] = x[lane] == mont[lane]->minus_one();
+                }
+            }
+        }
+
+        return passed;
+    }
+
+    // Screens a batch of candidates and runs base after base only on the survivors,
+    // packed densely into lanes - random composites rarely get past the first base
+    inline void test_batch(const uint64_t *candidates, size_t count, bool *is_prime)
+    {
+        struct Pending
+        {
+            size_t index;
+            Montgomery mont;
+        };
+
+        std::vector<Pending> pending;
+        pending.reserve(count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            Screening screening = screen(candidates[i]);
+            is_prime[i] = screening != Screening::composite;
+            if (screening == Screening::undecided)
+                pending.push_back(Pending{i, Montgomery{candidates[i]}});
+        }
+
+        for (uint64_t base : bases)
+        {
+            if (pending.empty())
+                return;
+
+            size_t no_of_survivors = 0;
+            for (size_t group = 0; group < pending.size(); group += no_of_lanes)
+            {
+                std::array<const Montgomery *, no_of_lanes> mont;
+                for (size_t lane = 0; lane < no_of_lanes; ++lane)
+                    mont[lane] = &pending[std::min(group + lane, pending.size() - 1)].mont;
+
+                const auto passed = are_strong_probable_primes(mont, base);
+
+                for (size_t lane = 0; lane < no_of_lanes && group + lane < pending.size(); ++lane)
+                {
+                    if (passed[lane])
+                        pending[no_of_survivors++] = pending[group + lane];
+                    else
+                        is_prime[pending[group + lane].index] = false;
+                }
+            }
+            pending.erase(pending.begin() + no_of_survivors, pending.end());
+        }
+    }
+} // namespace miller_rabin_detail
+
+// Deterministic Miller-Rabin test valid for the full 64-bit range
+inline bool is_prime_miller_rabin(uint64_t n) noexcept
+{
+    using namespace miller_rabin_detail;
+
+    Screening screening = screen(n);
+    if (screening != Screening::undecided)
+        return screening == Screening::prime;
+
+    const Montgomery mont{n};
+    return std::all_of(bases.begin(), bases.end(), [&](uint64_t base) { return is_strong_probable_prime(mont, n, base); });
+}
+
+// Tests candidates in batches, interleaving four Montgomery multiplication chains at a time,
+// and writes a bool for each of them
+template <typename InputIterator, typename OutputIterator>
+OutputIterator is_prime_miller_rabin(InputIterator first, InputIterator last, OutputIterator out)
+{
+    using namespace miller_rabin_detail;
+
+    std::array<uint64_t, batch_size> candidates;
+    bool results[batch_size];
+
+    while (first != last)
+    {
+        size_t count = 0;
+        for (; count < batch_size && first != last; ++count, ++first)
+            candidates[count] = *first;
+
+        test_batch(candidates.data(), count, results);
+        out = std::copy(results, results + count, out);
+    }
+
+    return out;
+}
+
+template <typename ExecutionPolicy, typename RandomAccessIterator, typename RandomAccessOutputIterator>
+RandomAccessOutputIterator is_prime_miller_rabin(ExecutionPolicy &&policy, RandomAccessIterator first, RandomAccessIterator last, RandomAccessOutputIterator out)
+{
+    constexpr size_t block_size = 1024;
+    const size_t size = std::distance(first, last);
+
+    std::vector<size_t> blocks((size + block_size - 1) / block_size);
+    std::iota(blocks.begin(), blocks.end(), 0);
+
+    std::for_each(std::forward<ExecutionPolicy>(policy), blocks.begin(), blocks.end(), [&](size_t block) {
+        const size_t block_begin = block * block_size;
+        const size_t block_end = std::min(block_begin + block_size, size);
+        is_prime_miller_rabin(first + block_begin, first + block_end, out + block_begin);
+    });
+
+    return out + size;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+// High 64 bits of the 128-bit product a * b
+inline uint64_t mul_high(uint64_t a, uint64_t b) noexcept
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    return __umulh(a, b);
+#else
+    return static_cast<uint64_t>((static_cast<unsigned __int128>(a) * b) >> 64);
+#endif
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Two cache lines - the adjacent-line prefetcher moves lines in pairs, so a slot shares
+// no prefetched pair with its neighbours either
+constexpr size_t per_thread_slot_alignment = 128;
+
+namespace per_thread_detail
+{
+    // Dense indexes of the running threads - the index of a finished thread is handed to
+    // the next new one, so the number of slots stays at the number of threads alive at once
+    class ThreadIndexes
+    {
+    public:
+        // Never destroyed - thread_local indexes of threads of static pools are released at exit,
+        // possibly after the statics of this translation unit are gone
+        static ThreadIndexes &instance()
+        {
+            static auto *indexes = new ThreadIndexes;
+            return *indexes;
+        }
+
+        size_t acquire()
+        {
+            std::lock_guard lock{mtx_};
+            if (free_.empty())
+                return next_++;
+
+            const size_t index = free_.back();
+            free_.pop_back();
+            return index;
+        }
+
+        void release(size_t index)
+        {
+            std::lock_guard lock{mtx_};
+            free_.push_back(index);
+        }
+
+    private:
+        std::mutex mtx_;
+        std::vector<size_t> free_;
+        size_t next_ = 0;
+    };
+
+    struct ThreadIndex
+    {
+        ThreadIndex()
+            : value{ThreadIndexes::instance().acquire()}
+        {
+        }
+
+        ~ThreadIndex()
+        {
+            ThreadIndexes::instance().release(value);
+        }
+
+        const size_t value;
+    };
+
+    inline size_t thread_index()
+    {
+        thread_local const ThreadIndex index;
+        return index.value;
+    }
+} // namespace per_thread_detail
+
+// One value of T for every thread that calls local(), each in its own slot of Alignment bytes, so
+// threads updating their values do not invalidate each other's cache lines. combine() folds the slots
+// after the parallel part - it must not run concurrently with local().
+// PerThread<T, alignof(T)> packs the slots densely - the false-sharing baseline.
+template <typename T, size_t Alignment = per_thread_slot_alignment>
+class PerThread
+{
+public:
+    explicit PerThread(T initial = T{})
+        : initial_{std::move(initial)}
+    {
+    }
+
+    PerThread(const PerThread &) = delete;
+    PerThread &operator=(const PerThread &) = delete;
+
+    ~PerThread()
+    {
+        for (auto &chunk : chunks_)
+            delete[] chunk.load(std::memory_order_relaxed);
+    }
+
+    // The slot of the calling thread, holding a copy of the initial value on first use
+    T &local()
+    {
+        const size_t index = per_thread_detail::thread_index();
+        if (index >= max_chunks * chunk_size)
+            throw std::length_error("PerThread: too many threads");
+
+        Slot *chunk = chunks_[index / chunk_size].load(std::memory_order_acquire);
+        if (!chunk)
+            chunk = allocate_chunk(index / chunk_size);
+
+        Slot &slot = chunk[index % chunk_size];
+        if (!slot.used)
+        {
+            slot.value = initial_;
+            slot.used = true;
+        }
+        return slot.value;
+    }
+
+    // f(value) for the value of every thread that called local(), in the order of the thread indexes
+    template <typename Function>
+    void for_each(Function f) const
+    {
+        for (const auto &chunk : chunks_)
+        {
+            const Slot *slots = chunk.load(std::memory_order_acquire);
+            for (size_t i = 0; slots && i < chunk_size; ++i)
+            {
+                if (slots[i].used)
+                    f(slots[i].value);
+            }
+        }
+    }
+
+    template <typename U, typename BinaryOperation>
+    U combine(U init, BinaryOperation op) const
+    {
+        for_each([&](const T &value) { init = op(std::move(init), value); });
+        return init;
+    }
+
+    size_t size() const
+    {
+        size_t no_of_values = 0;
+        for_each([&](const T &) { ++no_of_values; });
+        return no_of_values;
+    }
+
+private:
+    struct alignas(Alignment) Slot
+    {
+        T value{};
+        bool used = false;
+    };
+
+    static constexpr size_t chunk_size = 64;
+    static constexpr size_t max_chunks = 64;
+
+    Slot *allocate_chunk(size_t chunk_index)
+    {
+        std::lock_guard lock{mtx_};
+        Slot *chunk = chunks_[chunk_index].load(std::memory_order_relaxed);
+        if (!chunk)
+        {
+            chunk = new Slot[chunk_size];
+            chunks_[chunk_index].store(chunk, std::memory_order_release);
+        }
+        return chunk;
+    }
+
+    T initial_;
+    std::array<std::atomic<Slot *>, max_chunks> chunks_{};
+    std::mutex mtx_;
+};
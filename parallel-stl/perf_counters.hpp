@@ -0,0 +1,359 @@
+#pragma once
+
+#include "thread_hooks.hpp"
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define PSTL_HAS_PERF_EVENTS 1
+#endif
+
+#if __has_include(<tbb/task_scheduler_observer.h>)
+#include <tbb/task_scheduler_observer.h>
+#define PSTL_HAS_TBB_OBSERVER 1
+#endif
+
+enum class PerfEvent
+{
+    cycles,
+    instructions,
+    l1d_misses,
+    llc_misses,
+    branch_misses
+};
+
+constexpr size_t no_of_perf_events = 5;
+
+inline const char *perf_event_name(PerfEvent event)
+{
+    static const char *names[no_of_perf_events] = {"cycles", "instructions", "L1D misses", "LLC misses", "branch misses"};
+    return names[static_cast<size_t>(event)];
+}
+
+struct PerfSnapshot
+{
+    std::array<double, no_of_perf_events> values{};
+};
+
+#ifdef PSTL_HAS_PERF_EVENTS
+// Hardware counters of one thread, opened as a single group so they are scheduled together
+class ThreadCounterGroup
+{
+public:
+    // tid 0: the calling thread
+    explicit ThreadCounterGroup(pid_t tid = 0)
+    {
+        const std::array<std::pair<uint32_t, uint64_t>, no_of_perf_events> events = {{
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        }};
+
+        for (size_t i = 0; i < events.size(); ++i)
+        {
+            perf_event_attr attributes;
+            std::memset(&attributes, 0, sizeof(attributes));
+            attributes.size = sizeof(attributes);
+            attributes.type = events[i].first;
+            attributes.config = events[i].second;
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+            attributes.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            int fd = static_cast<int>(::syscall(SYS_perf_event_open, &attributes, tid, -1, leader_fd_, 0));
+            if (fd == -1)
+            {
+                if (leader_fd_ == -1)
+                    error_ = std::strerror(errno);
+                continue;
+            }
+
+            if (leader_fd_ == -1)
+                leader_fd_ = fd;
+            else
+                member_fds_.push_back(fd);
+
+            opened_events_.push_back(static_cast<PerfEvent>(i));
+        }
+    }
+
+    ThreadCounterGroup(const ThreadCounterGroup &) = delete;
+    ThreadCounterGroup &operator=(const ThreadCounterGroup &) = delete;
+
+    ~ThreadCounterGroup()
+    {
+        for (int fd : member_fds_)
+            ::close(fd);
+        if (leader_fd_ != -1)
+            ::close(leader_fd_);
+    }
+
+    const std::vector<PerfEvent> &opened_events() const noexcept
+    {
+        return opened_events_;
+    }
+
+    const std::string &error() const noexcept
+    {
+        return error_;
+    }
+
+    // Adds the counts of the thread (scaled if the group was multiplexed) to the snapshot
+    void add_to(PerfSnapshot &snapshot) const
+    {
+        if (leader_fd_ == -1)
+            return;
+
+        std::array<uint64_t, 3 + no_of_perf_events> buffer{};
+        if (::read(leader_fd_, buffer.data(), sizeof(buffer)) <= 0)
+            return;
+
+        const uint64_t no_of_values = buffer[0];
+        const uint64_t time_enabled = buffer[1];
+        const uint64_t time_running = buffer[2];
+        const double scale = time_running > 0 ? static_cast<double>(time_enabled) / time_running : 0.0;
+
+        for (size_t i = 0; i < no_of_values && i < opened_events_.size(); ++i)
+            snapshot.values[static_cast<size_t>(opened_events_[i])] += buffer[3 + i] * scale;
+    }
+
+private:
+    int leader_fd_ = -1;
+    std::vector<int> member_fds_;
+    std::vector<PerfEvent> opened_events_;
+    std::string error_;
+};
+#endif
+
+// Process-wide view of the counters: every thread that runs benchmark code gets its own always-counting
+// group - the threads alive at enable(), then the main thread, the TBB workers and the threads of the
+// work-stealing pool and the pipeline as they start. The counts of a thread that ended are kept,
+// a snapshot sums all of them.
+class PerfCounters
+{
+public:
+    // Never destroyed - threads of static pools end after the statics of other units are gone
+    static PerfCounters &instance()
+    {
+        static auto *counters = new PerfCounters;
+        return *counters;
+    }
+
+    void enable()
+    {
+        enabled_ = true;
+        register_running_threads();
+        register_current_thread();
+
+        if (hooks_installed_)
+            return;
+        hooks_installed_ = true;
+
+        ThreadStartHooks::add([] { PerfCounters::instance().register_current_thread(); });
+#ifdef PSTL_HAS_TBB_OBSERVER
+        worker_observer_ = std::make_unique<WorkerObserver>();
+#endif
+    }
+
+    // The groups stay open, enable() continues with them and adds the threads started meanwhile
+    void disable()
+    {
+        enabled_ = false;
+    }
+
+    bool enabled() const noexcept
+    {
+        return enabled_;
+    }
+
+    bool available(PerfEvent event) const noexcept
+    {
+        return available_[static_cast<size_t>(event)];
+    }
+
+    bool any_available() const noexcept
+    {
+        for (bool available : available_)
+            if (available)
+                return true;
+        return false;
+    }
+
+    const std::string &unavailable_reason() const noexcept
+    {
+        return unavailable_reason_;
+    }
+
+    // A group of the calling thread, counted until the thread ends
+    void register_current_thread()
+    {
+        if (!enabled_)
+            return;
+
+#ifdef PSTL_HAS_PERF_EVENTS
+        // retires the group when the thread ends
+        thread_local struct Registration
+        {
+            ~Registration()
+            {
+                if (tid != 0)
+                    PerfCounters::instance().retire(tid);
+            }
+
+            pid_t tid = 0;
+        } registration;
+
+        if (registration.tid != 0)
+            return;
+        registration.tid = static_cast<pid_t>(::syscall(SYS_gettid));
+
+        auto group = std::make_unique<ThreadCounterGroup>();
+
+        std::lock_guard lock{mtx_};
+        // opened from outside by register_running_threads - the group of the thread itself replaces it
+        retire_locked(registration.tid);
+        add_locked(registration.tid, std::move(group));
+#else
+        std::lock_guard lock{mtx_};
+        unavailable_reason_ = "perf_event_open is available on Linux only";
+#endif
+    }
+
+    PerfSnapshot snapshot()
+    {
+#ifdef PSTL_HAS_PERF_EVENTS
+        std::lock_guard lock{mtx_};
+        PerfSnapshot snapshot = retired_;
+        for (const auto &[tid, group] : groups_)
+            group->add_to(snapshot);
+        return snapshot;
+#else
+        return PerfSnapshot{};
+#endif
+    }
+
+private:
+    PerfCounters() = default;
+
+#ifdef PSTL_HAS_PERF_EVENTS
+    // TBB workers already in their arena and pool workers started before enable()
+    void register_running_threads()
+    {
+        std::error_code error;
+        for (const auto &entry : std::filesystem::directory_iterator{"/proc/self/task", error})
+        {
+            const auto tid = static_cast<pid_t>(std::stol(entry.path().filename().string()));
+            auto group = std::make_unique<ThreadCounterGroup>(tid);
+
+            std::lock_guard lock{mtx_};
+            if (groups_.count(tid) == 0)
+                add_locked(tid, std::move(group));
+        }
+    }
+
+    void add_locked(pid_t tid, std::unique_ptr<ThreadCounterGroup> group)
+    {
+        if (!availability_known_)
+        {
+            availability_known_ = true;
+            for (PerfEvent event : group->opened_events())
+                available_[static_cast<size_t>(event)] = true;
+            unavailable_reason_ = group->error();
+        }
+        groups_[tid] = std::move(group);
+    }
+
+    void retire(pid_t tid)
+    {
+        std::lock_guard lock{mtx_};
+        retire_locked(tid);
+    }
+
+    // Keeps the counts of the group and closes it
+    void retire_locked(pid_t tid)
+    {
+        if (const auto group = groups_.find(tid); group != groups_.end())
+        {
+            group->second->add_to(retired_);
+            groups_.erase(group);
+        }
+    }
+#else
+    void register_running_threads()
+    {
+    }
+#endif
+
+#ifdef PSTL_HAS_TBB_OBSERVER
+    class WorkerObserver : public tbb::task_scheduler_observer
+    {
+    public:
+        WorkerObserver()
+        {
+            observe(true);
+        }
+
+        ~WorkerObserver()
+        {
+            observe(false);
+        }
+
+        void on_scheduler_entry(bool) override
+        {
+            PerfCounters::instance().register_current_thread();
+        }
+    };
+
+    std::unique_ptr<WorkerObserver> worker_observer_;
+#endif
+
+    std::atomic<bool> enabled_ = false;
+    bool hooks_installed_ = false;
+    std::array<bool, no_of_perf_events> available_{};
+    std::string unavailable_reason_;
+    std::mutex mtx_;
+#ifdef PSTL_HAS_PERF_EVENTS
+    bool availability_known_ = false;
+    std::map<pid_t, std::unique_ptr<ThreadCounterGroup>> groups_;
+    PerfSnapshot retired_;
+#endif
+};
+
+// Counts while alive, with or without --perf-counters
+class PerfCountersScope
+{
+public:
+    PerfCountersScope()
+        : was_enabled_{PerfCounters::instance().enabled()}
+    {
+        PerfCounters::instance().enable();
+    }
+
+    PerfCountersScope(const PerfCountersScope &) = delete;
+    PerfCountersScope &operator=(const PerfCountersScope &) = delete;
+
+    ~PerfCountersScope()
+    {
+        if (!was_enabled_)
+            PerfCounters::instance().disable();
+    }
+
+private:
+    bool was_enabled_;
+};
@@ -0,0 +1,203 @@
+#pragma once
+
+#include "thread_hooks.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Blocking FIFO of limited size between two pipeline stages - a full queue stalls the producer,
+// so a fast stage cannot run ahead of a slow one and buffer the whole input
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(size_t capacity)
+        : capacity_{std::max<size_t>(capacity, 1)}
+    {
+    }
+
+    BoundedQueue(const BoundedQueue &) = delete;
+    BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+    // false - the queue was closed, the item is dropped
+    bool push(T item)
+    {
+        std::unique_lock lock{mtx_};
+        cv_not_full_.wait(lock, [this] { return items_.size() < capacity_ || closed_; });
+        if (closed_)
+            return false;
+
+        items_.push_back(std::move(item));
+        lock.unlock();
+        cv_not_empty_.notify_one();
+        return true;
+    }
+
+    // std::nullopt - the queue is closed and drained
+    std::optional<T> pop()
+    {
+        std::unique_lock lock{mtx_};
+        cv_not_empty_.wait(lock, [this] { return !items_.empty() || closed_; });
+        if (items_.empty())
+            return std::nullopt;
+
+        T item = std::move(items_.front());
+        items_.pop_front();
+        lock.unlock();
+        cv_not_full_.notify_one();
+        return item;
+    }
+
+    // No more pushes - consumers get the remaining items, then std::nullopt
+    void close()
+    {
+        {
+            std::lock_guard lock{mtx_};
+            closed_ = true;
+        }
+        cv_not_empty_.notify_all();
+        cv_not_full_.notify_all();
+    }
+
+private:
+    const size_t capacity_;
+    std::deque<T> items_;
+    bool closed_ = false;
+    std::mutex mtx_;
+    std::condition_variable cv_not_empty_;
+    std::condition_variable cv_not_full_;
+};
+
+// Threads of a streaming pipeline: a source feeds the first queue, every stage runs its own
+// number of threads between two queues and the last thread of a stage closes its output.
+// An exception stops the pipeline (all queues are closed) and is rethrown by wait().
+class Pipeline
+{
+public:
+    Pipeline() = default;
+    Pipeline(const Pipeline &) = delete;
+    Pipeline &operator=(const Pipeline &) = delete;
+
+    ~Pipeline()
+    {
+        join();
+    }
+
+    // source(emit) calls emit(item) for every item, emit returns false once the pipeline stopped
+    template <typename T, typename Source>
+    void add_source(BoundedQueue<T> &out, Source source)
+    {
+        register_queue(out);
+        start_thread([this, &out, source = std::move(source)]() mutable {
+            guarded([&] { source([&](T item) { return out.push(std::move(item)); }); });
+            out.close();
+        });
+    }
+
+    // out = function(in) for every item, on parallelism threads - the order of the items is not kept
+    template <typename In, typename Out, typename Function>
+    void add_stage(BoundedQueue<In> &in, BoundedQueue<Out> &out, size_t parallelism, Function function)
+    {
+        register_queue(out);
+        const size_t no_of_threads = std::max<size_t>(parallelism, 1);
+        auto running = std::make_shared<std::atomic<size_t>>(no_of_threads);
+
+        for (size_t i = 0; i < no_of_threads; ++i)
+        {
+            start_thread([this, &in, &out, running, function]() mutable {
+                guarded([&] {
+                    while (auto item = in.pop())
+                    {
+                        if (!out.push(function(std::move(*item))))
+                            break;
+                    }
+                });
+
+                if (--*running == 0)
+                    out.close();
+            });
+        }
+    }
+
+    // function(in) for every item, on parallelism threads
+    template <typename In, typename Function>
+    void add_sink(BoundedQueue<In> &in, size_t parallelism, Function function)
+    {
+        for (size_t i = 0; i < std::max<size_t>(parallelism, 1); ++i)
+        {
+            start_thread([this, &in, function]() mutable {
+                guarded([&] {
+                    while (auto item = in.pop())
+                        function(std::move(*item));
+                });
+            });
+        }
+    }
+
+    void wait()
+    {
+        join();
+        if (error_)
+            std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+
+private:
+    template <typename Body>
+    void start_thread(Body body)
+    {
+        threads_.emplace_back([body = std::move(body)]() mutable {
+            ThreadStartHooks::run();
+            body();
+        });
+    }
+
+    template <typename T>
+    void register_queue(BoundedQueue<T> &queue)
+    {
+        std::lock_guard lock{mtx_};
+        close_queues_.push_back([&queue] { queue.close(); });
+    }
+
+    template <typename Function>
+    void guarded(Function function)
+    {
+        try
+        {
+            function();
+        }
+        catch (...)
+        {
+            std::lock_guard lock{mtx_};
+            if (!error_)
+                error_ = std::current_exception();
+            for (const auto &close_queue : close_queues_)
+                close_queue();
+        }
+    }
+
+    void join()
+    {
+        for (auto &thd : threads_)
+        {
+            if (thd.joinable())
+                thd.join();
+        }
+        threads_.clear();
+    }
+
+    std::vector<std::thread> threads_;
+    std::vector<std::function<void()>> close_queues_;
+    std::exception_ptr error_;
+    std::mutex mtx_;
+};
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+struct AllocationCounts
+{
+    size_t allocations = 0;
+    size_t deallocations = 0;
+    size_t bytes = 0; // allocated
+};
+
+// Passes every request on to the upstream resource and counts it
+class CountingResource : public std::pmr::memory_resource
+{
+public:
+    explicit CountingResource(std::pmr::memory_resource *upstream = std::pmr::get_default_resource()) noexcept
+        : upstream_{upstream}
+    {
+    }
+
+    AllocationCounts counts() const noexcept
+    {
+        return {allocations_, deallocations_, bytes_};
+    }
+
+    void reset_counts() noexcept
+    {
+        allocations_ = 0;
+        deallocations_ = 0;
+        bytes_ = 0;
+    }
+
+private:
+    void *do_allocate(size_t bytes, size_t alignment) override
+    {
+        void *p = upstream_->allocate(bytes, alignment);
+        ++allocations_;
+        bytes_ += bytes;
+        return p;
+    }
+
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override
+    {
+        upstream_->deallocate(p, bytes, alignment);
+        ++deallocations_;
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    std::pmr::memory_resource *upstream_;
+    std::atomic<size_t> allocations_{0};
+    std::atomic<size_t> deallocations_{0};
+    std::atomic<size_t> bytes_{0};
+};
+
+using PmrDocumentContent = std::pmr::vector<std::pmr::string>;
+
+enum class ArenaKind
+{
+    none,      // every allocation goes to new/delete - what std::allocator does
+    monotonic, // bump allocation, deallocation is a no-op
+    pool       // free lists per block size, freed blocks are reused
+};
+
+// Memory for copies of a document, released all at once by reset(). Requests of the documents
+// and the allocations the arena makes from new/delete are counted separately, both since the last reset.
+// A monotonic arena keeps one buffer over resets, grown to what the previous round needed,
+// so repeating the same copies after a reset does not allocate at all.
+// Not synchronized: algorithms running in parallel on a copy may only move and swap the words.
+class DocumentArena
+{
+public:
+    explicit DocumentArena(ArenaKind kind, size_t initial_bytes = 0)
+        : kind_{kind}, requests_{make_arena(initial_bytes)}
+    {
+    }
+
+    DocumentArena(const DocumentArena &) = delete;
+    DocumentArena &operator=(const DocumentArena &) = delete;
+
+    ArenaKind kind() const noexcept
+    {
+        return kind_;
+    }
+
+    std::pmr::memory_resource *resource() noexcept
+    {
+        return &requests_;
+    }
+
+    template <typename InputIterator>
+    PmrDocumentContent copy(InputIterator first, InputIterator last)
+    {
+        PmrDocumentContent document{resource()};
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<InputIterator>::iterator_category>)
+            document.reserve(std::distance(first, last));
+
+        for (; first != last; ++first)
+            document.emplace_back(std::string_view{*first});
+        return document;
+    }
+
+    // Documents allocated from the arena must be destroyed before
+    void reset()
+    {
+        if (monotonic_)
+        {
+            const size_t used = buffer_size_ + upstream_.counts().bytes;
+            monotonic_.reset();
+            if (used > buffer_size_)
+                allocate_buffer(used);
+            monotonic_.emplace(buffer_.get(), buffer_size_, &upstream_);
+        }
+        else if (pool_)
+        {
+            pool_->release();
+        }
+
+        requests_.reset_counts();
+        upstream_.reset_counts();
+    }
+
+    // Requests of the documents
+    AllocationCounts requests() const noexcept
+    {
+        return requests_.counts();
+    }
+
+    // Allocations of the arena from new/delete
+    AllocationCounts upstream() const noexcept
+    {
+        return upstream_.counts();
+    }
+
+private:
+    std::pmr::memory_resource *make_arena(size_t initial_bytes)
+    {
+        switch (kind_)
+        {
+        case ArenaKind::monotonic:
+            allocate_buffer(initial_bytes);
+            return &monotonic_.emplace(buffer_.get(), buffer_size_, &upstream_);
+        case ArenaKind::pool:
+            return &pool_.emplace(&upstream_);
+        default:
+            return &upstream_;
+        }
+    }
+
+    void allocate_buffer(size_t size)
+    {
+        buffer_size_ = std::max<size_t>(size, 1024);
+        buffer_.reset(new std::byte[buffer_size_]);
+    }
+
+    ArenaKind kind_;
+    CountingResource upstream_{std::pmr::new_delete_resource()};
+    std::unique_ptr<std::byte[]> buffer_;
+    size_t buffer_size_ = 0;
+    std::optional<std::pmr::monotonic_buffer_resource> monotonic_;
+    std::optional<std::pmr::unsynchronized_pool_resource> pool_;
+    CountingResource requests_;
+};
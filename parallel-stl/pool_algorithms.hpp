@@ -0,0 +1,169 @@
+#pragma once
+
+#include "stable_partition.hpp"
+#include "work_stealing_pool.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace pstl
+{
+    // Execution policy of the algorithms below - which pool runs them and how many elements a task
+    // gets at least (0 - about 8 tasks per worker). Pinned workers are a property of the pool.
+    struct PoolPolicy
+    {
+        explicit PoolPolicy(WorkStealingPool &pool, size_t grain_size = 0)
+            : pool{&pool}, grain_size{grain_size}
+        {
+        }
+
+        PoolPolicy with_grain_size(size_t grain_size) const
+        {
+            return PoolPolicy{*pool, grain_size};
+        }
+
+        WorkStealingPool *pool;
+        size_t grain_size;
+    };
+
+    namespace detail
+    {
+        inline size_t grain_of(const PoolPolicy &policy, size_t size, size_t min_grain = 1)
+        {
+            const size_t grain = policy.grain_size ? policy.grain_size : size / (8 * policy.pool->size());
+            return std::max(grain, min_grain);
+        }
+
+        // Halves [first, last) until it fits the grain - the upper halves become tasks that idle
+        // workers steal, the lower half stays on the current thread
+        template <typename Body>
+        void split(size_t first, size_t last, size_t grain, const Body &body, TaskGroup &group)
+        {
+            while (last - first > grain)
+            {
+                const size_t middle = first + (last - first) / 2;
+                group.run([=, &body, &group] { split(middle, last, grain, body, group); });
+                last = middle;
+            }
+            body(first, last);
+        }
+
+        // body(first, last) for subranges of [0, size) in parallel
+        template <typename Body>
+        void parallel_for(const PoolPolicy &policy, size_t size, size_t grain, const Body &body)
+        {
+            if (size == 0)
+                return;
+
+            TaskGroup group{*policy.pool};
+            split(0, size, grain, body, group);
+            group.wait();
+        }
+
+        template <typename RandomAccessIterator, typename Compare>
+        void quick_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp, size_t grain, TaskGroup &group)
+        {
+            while (static_cast<size_t>(last - first) > grain)
+            {
+                auto a = first, b = first + (last - first) / 2, c = last - 1;
+                if (comp(*b, *a))
+                    std::swap(a, b);
+                if (comp(*c, *b))
+                    b = comp(*c, *a) ? a : c;
+                const auto pivot = *b;
+
+                // three-way split - runs of equal keys are not sorted again
+                auto middle_first = std::partition(first, last, [&](const auto &item) { return comp(item, pivot); });
+                auto middle_last = std::partition(middle_first, last, [&](const auto &item) { return !comp(pivot, item); });
+
+                group.run([=, &group] { quick_sort(middle_last, last, comp, grain, group); });
+                last = middle_first;
+            }
+            std::sort(first, last, comp);
+        }
+    } // namespace detail
+
+    template <typename RandomAccessIterator, typename Function>
+    void for_each(const PoolPolicy &policy, RandomAccessIterator first, RandomAccessIterator last, Function f)
+    {
+        const size_t size = std::distance(first, last);
+        detail::parallel_for(policy, size, detail::grain_of(policy, size), [&](size_t block_first, size_t block_last) {
+            std::for_each(first + block_first, first + block_last, f);
+        });
+    }
+
+    template <typename RandomAccessIterator, typename RandomAccessOutputIterator, typename UnaryOperation>
+    RandomAccessOutputIterator transform(const PoolPolicy &policy, RandomAccessIterator first, RandomAccessIterator last, RandomAccessOutputIterator out, UnaryOperation op)
+    {
+        const size_t size = std::distance(first, last);
+        detail::parallel_for(policy, size, detail::grain_of(policy, size), [&](size_t block_first, size_t block_last) {
+            std::transform(first + block_first, first + block_last, out + block_first, op);
+        });
+        return out + size;
+    }
+
+    // Partial results of the blocks are combined in block order - the same result for every
+    // run even if the reduction is not associative for floating point
+    template <typename RandomAccessIterator, typename T, typename BinaryReductionOp, typename UnaryTransformOp>
+    T transform_reduce(const PoolPolicy &policy, RandomAccessIterator first, RandomAccessIterator last, T init, BinaryReductionOp reduce, UnaryTransformOp transform)
+    {
+        const size_t size = std::distance(first, last);
+        const size_t grain = detail::grain_of(policy, size);
+        const size_t no_of_blocks = (size + grain - 1) / grain;
+
+        std::vector<std::optional<T>> partials(no_of_blocks);
+        detail::parallel_for(policy, no_of_blocks, 1, [&](size_t blocks_first, size_t blocks_last) {
+            for (size_t block = blocks_first; block < blocks_last; ++block)
+            {
+                auto it = first + block * grain;
+                const auto block_last = first + std::min(size, (block + 1) * grain);
+                T partial = transform(*it);
+                while (++it != block_last)
+                    partial = reduce(std::move(partial), transform(*it));
+                partials[block] = std::move(partial);
+            }
+        });
+
+        for (auto &partial : partials)
+            init = reduce(std::move(init), std::move(*partial));
+        return init;
+    }
+
+    template <typename RandomAccessIterator, typename Compare = std::less<>>
+    void sort(const PoolPolicy &policy, RandomAccessIterator first, RandomAccessIterator last, Compare comp = Compare{})
+    {
+        const size_t size = std::distance(first, last);
+        const size_t grain = detail::grain_of(policy, size, 2048);
+
+        TaskGroup group{*policy.pool};
+        detail::quick_sort(first, last, comp, grain, group);
+        group.wait();
+    }
+
+    // Stable: blocked_stable_partition() with the blocks run by the pool
+    template <typename RandomAccessIterator, typename Predicate>
+    RandomAccessIterator partition(const PoolPolicy &policy, RandomAccessIterator first, RandomAccessIterator last, Predicate pred)
+    {
+        const size_t size = std::distance(first, last);
+        const size_t grain = detail::grain_of(policy, size);
+
+        auto for_each_block = [&policy](const std::vector<size_t> &blocks, const auto &body) {
+            detail::parallel_for(policy, blocks.size(), 1, [&](size_t blocks_first, size_t blocks_last) {
+                std::for_each(blocks.begin() + blocks_first, blocks.begin() + blocks_last, body);
+            });
+        };
+
+        const auto masks = stable_partition_detail::evaluate_blocks_with(for_each_block, first, size, pred, grain);
+        auto buffer = stable_partition_detail::scatter_blocks(for_each_block, first, size, masks);
+
+        detail::parallel_for(policy, size, masks.block_size, [&](size_t block_first, size_t block_last) {
+            std::move(buffer.begin() + block_first, buffer.begin() + block_last, first + block_first);
+        });
+
+        return first + masks.total_trues();
+    }
+} // namespace pstl
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+#include <bitset>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <execution>
+#include <numeric>
+#include <vector>
+
+// Bit-packed primality table for [0, limit] - bit i stands for the odd number 2 * i + 1.
+// The table is built with a segmented sieve of Eratosthenes; segments fit in L1 cache
+// and are sieved independently with the execution policy.
+class PrimeTable
+{
+public:
+    static constexpr uint64_t segment_words = 4 * 1024; // 32 KiB
+    static constexpr uint64_t segment_bits = segment_words * 64;
+
+    template <typename ExecutionPolicy>
+    PrimeTable(ExecutionPolicy &&policy, uint64_t limit)
+        : limit_{limit}, bits_((no_of_odds(limit) + 63) / 64)
+    {
+        const std::vector<uint64_t> base_primes = odd_primes_up_to(integer_sqrt(limit));
+
+        std::vector<uint64_t> segments((bits_.size() + segment_words - 1) / segment_words);
+        std::iota(segments.begin(), segments.end(), 0);
+
+        std::for_each(std::forward<ExecutionPolicy>(policy), segments.begin(), segments.end(), [&](uint64_t segment) {
+            sieve_segment(segment, base_primes);
+        });
+    }
+
+    explicit PrimeTable(uint64_t limit)
+        : PrimeTable(std::execution::seq, limit)
+    {
+    }
+
+    bool is_prime(uint64_t number) const noexcept
+    {
+        assert(number <= limit_);
+
+        if (number % 2 == 0)
+            return number == 2;
+
+        const uint64_t index = number / 2;
+        return (bits_[index / 64] >> (index % 64)) & 1;
+    }
+
+    uint64_t limit() const noexcept
+    {
+        return limit_;
+    }
+
+    uint64_t count() const noexcept
+    {
+        return std::accumulate(bits_.begin(), bits_.end(), uint64_t{limit_ >= 2},
+            [](uint64_t total, uint64_t word) { return total + std::bitset<64>(word).count(); });
+    }
+
+private:
+    static uint64_t no_of_odds(uint64_t limit)
+    {
+        return (limit + 1) / 2;
+    }
+
+    static uint64_t integer_sqrt(uint64_t number)
+    {
+        uint64_t root = static_cast<uint64_t>(std::sqrt(static_cast<double>(number)));
+        while (root * root > number)
+            --root;
+        while ((root + 1) * (root + 1) <= number)
+            ++root;
+        return root;
+    }
+
+    static std::vector<uint64_t> odd_primes_up_to(uint64_t limit)
+    {
+        std::vector<bool> composite(limit + 1);
+        std::vector<uint64_t> primes;
+
+        for (uint64_t number = 3; number <= limit; number += 2)
+        {
+            if (composite[number])
+                continue;
+
+            primes.push_back(number);
+            for (uint64_t multiple = number * number; multiple <= limit; multiple += 2 * number)
+                composite[multiple] = true;
+        }
+
+        return primes;
+    }
+
+    void sieve_segment(uint64_t segment, const std::vector<uint64_t> &base_primes)
+    {
+        const uint64_t first_word = segment * segment_words;
+        const uint64_t last_word = std::min<uint64_t>(first_word + segment_words, bits_.size());
+        const uint64_t first_bit = first_word * 64;
+        const uint64_t last_bit = std::min(last_word * 64, no_of_odds(limit_));
+
+        std::fill(bits_.begin() + first_word, bits_.begin() + last_word, ~uint64_t{0});
+
+        for (uint64_t prime : base_primes)
+        {
+            // first odd multiple of prime inside of the segment, not below prime squared
+            const uint64_t first_number = 2 * first_bit + 1;
+            uint64_t multiple = std::max(prime * prime, (first_number + prime - 1) / prime * prime);
+            if (multiple % 2 == 0)
+                multiple += prime;
+
+            for (uint64_t bit = multiple / 2; bit < last_bit; bit += prime)
+                bits_[bit / 64] &= ~(uint64_t{1} << (bit % 64));
+        }
+
+        if (segment == 0)
+            bits_[0] &= ~uint64_t{1}; // 1 is not a prime
+
+        if (last_word == bits_.size() && last_bit % 64 != 0)
+            bits_[last_word - 1] &= (uint64_t{1} << (last_bit % 64)) - 1;
+    }
+
+    uint64_t limit_;
+    std::vector<uint64_t> bits_;
+};
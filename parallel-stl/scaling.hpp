@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if __has_include(<tbb/global_control.h>)
+#include <tbb/global_control.h>
+#define PSTL_HAS_TBB_GLOBAL_CONTROL 1
+#endif
+
+// A case of the scaling sweep prepares its data for the requested size
+// and returns the time of the measured algorithm only
+struct ScalingCase
+{
+    std::string name;
+    std::function<std::chrono::nanoseconds(size_t size)> run;
+};
+
+struct ScalingPoint
+{
+    std::string mode; // "strong" - fixed total size, "weak" - fixed size per thread
+    std::string name;
+    size_t threads;
+    size_t size;
+    double median_ms;
+    double speedup;
+    double efficiency;
+};
+
+template <typename Function>
+std::chrono::nanoseconds time_it(Function &&function)
+{
+    auto start = std::chrono::steady_clock::now();
+    function();
+    return std::chrono::steady_clock::now() - start;
+}
+
+// Caps the number of worker threads used by the parallel algorithms while alive. Algorithms with
+// threads of their own (pools, pipelines) size them by active() - the innermost limit, if any.
+class ThreadLimit
+{
+public:
+    explicit ThreadLimit(size_t threads)
+        : previous_{std::exchange(current(), threads)}
+#ifdef PSTL_HAS_TBB_GLOBAL_CONTROL
+        , control_{std::make_unique<tbb::global_control>(tbb::global_control::max_allowed_parallelism, threads)}
+#endif
+    {
+    }
+
+    ThreadLimit(const ThreadLimit &) = delete;
+    ThreadLimit &operator=(const ThreadLimit &) = delete;
+
+    ~ThreadLimit()
+    {
+        current() = previous_;
+    }
+
+    static std::optional<size_t> active()
+    {
+        return current();
+    }
+
+private:
+    static std::optional<size_t> &current()
+    {
+        static std::optional<size_t> threads;
+        return threads;
+    }
+
+    std::optional<size_t> previous_;
+#ifdef PSTL_HAS_TBB_GLOBAL_CONTROL
+    std::unique_ptr<tbb::global_control> control_;
+#endif
+};
+
+inline std::vector<size_t> default_thread_counts()
+{
+    const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<size_t> threads;
+    for (size_t count = 1; count < cores; count *= 2)
+        threads.push_back(count);
+    threads.push_back(cores);
+
+    return threads;
+}
+
+inline double median_ms(const ScalingCase &scaling_case, size_t size, size_t repetitions)
+{
+    std::vector<double> times;
+    for (size_t i = 0; i < std::max<size_t>(repetitions, 1); ++i)
+        times.push_back(std::chrono::duration<double, std::milli>(scaling_case.run(size)).count());
+
+    std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+    return times[times.size() / 2];
+}
+
+// Strong scaling runs every size with every thread count, weak scaling grows the size
+// proportionally to the thread count; both relate to the first thread count
+inline std::vector<ScalingPoint> run_scaling_sweep(const std::vector<ScalingCase> &cases, const std::vector<size_t> &sizes,
+    const std::vector<size_t> &threads, size_t repetitions)
+{
+    std::vector<ScalingPoint> points;
+    const size_t base_threads = threads.front();
+
+    for (const auto &scaling_case : cases)
+    {
+        for (size_t size : sizes)
+        {
+            std::optional<double> strong_base_ms, weak_base_ms;
+
+            for (size_t thread_count : threads)
+            {
+                ThreadLimit thread_limit{thread_count};
+                const double scale = static_cast<double>(thread_count) / base_threads;
+
+                const double strong_ms = median_ms(scaling_case, size, repetitions);
+                strong_base_ms = strong_base_ms.value_or(strong_ms);
+                const double strong_speedup = *strong_base_ms / strong_ms;
+                points.push_back({"strong", scaling_case.name, thread_count, size, strong_ms, strong_speedup, strong_speedup / scale});
+
+                const size_t weak_size = static_cast<size_t>(size * scale);
+                const double weak_ms = median_ms(scaling_case, weak_size, repetitions);
+                weak_base_ms = weak_base_ms.value_or(weak_ms);
+                const double weak_efficiency = *weak_base_ms / weak_ms;
+                points.push_back({"weak", scaling_case.name, thread_count, weak_size, weak_ms, weak_efficiency * scale, weak_efficiency});
+            }
+        }
+    }
+
+    return points;
+}
+
+inline void write_csv(std::ostream &out, const std::vector<ScalingPoint> &points)
+{
+    out << "mode,case,threads,size,median_ms,speedup,efficiency\n";
+    for (const auto &point : points)
+    {
+        out << point.mode << ",\"" << point.name << "\"," << point.threads << ',' << point.size << ','
+            << point.median_ms << ',' << point.speedup << ',' << point.efficiency << '\n';
+    }
+}
+
+inline void write_json(std::ostream &out, const std::vector<ScalingPoint> &points)
+{
+    out << "[\n";
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        const auto &point = points[i];
+        out << "  {\"mode\": \"" << point.mode << "\", \"case\": \"" << point.name << "\", \"threads\": " << point.threads
+            << ", \"size\": " << point.size << ", \"median_ms\": " << point.median_ms << ", \"speedup\": " << point.speedup
+            << ", \"efficiency\": " << point.efficiency << '}' << (i + 1 < points.size() ? ",\n" : "\n");
+    }
+    out << "]\n";
+}
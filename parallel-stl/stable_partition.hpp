@@ -0,0 +1,114 @@
+#pragma once
+
+#include <algorithm>
+#include <bitset>
+#include <cstdint>
+#include <execution>
+#include <iterator>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace stable_partition_detail
+{
+    // pred of every element as one bit, blocks cover whole 64-bit mask words
+    struct BlockMasks
+    {
+        size_t block_size;
+        std::vector<uint64_t> mask;
+        std::vector<size_t> trues_before; // of every block, the last entry is the total
+        std::vector<size_t> blocks;       // indexes to run the blocks with a policy
+
+        size_t total_trues() const noexcept
+        {
+            return trues_before.back();
+        }
+
+        bool is_true(size_t i) const noexcept
+        {
+            return (mask[i / 64] >> (i % 64)) & 1;
+        }
+    };
+
+    // for_each_block(blocks, body) calls body(block) for every block of blocks, in parallel or not
+    template <typename ExecutionPolicy>
+    auto for_each_block_of(ExecutionPolicy &policy)
+    {
+        return [&policy](const std::vector<size_t> &blocks, const auto &body) { std::for_each(policy, blocks.begin(), blocks.end(), body); };
+    }
+
+    template <typename ForEachBlock, typename RandomAccessIterator, typename Predicate>
+    BlockMasks evaluate_blocks_with(ForEachBlock for_each_block, RandomAccessIterator first, size_t size, Predicate pred, size_t block_size)
+    {
+        block_size = std::max<size_t>((block_size + 63) / 64 * 64, 64);
+        const size_t no_of_blocks = (size + block_size - 1) / block_size;
+
+        BlockMasks masks{block_size, std::vector<uint64_t>((size + 63) / 64), std::vector<size_t>(no_of_blocks + 1), std::vector<size_t>(no_of_blocks)};
+        std::iota(masks.blocks.begin(), masks.blocks.end(), size_t{0});
+
+        for_each_block(masks.blocks, [&](size_t block) {
+            const size_t block_last = std::min(size, (block + 1) * block_size);
+            size_t trues = 0;
+            for (size_t word_first = block * block_size; word_first < block_last; word_first += 64)
+            {
+                uint64_t bits = 0;
+                for (size_t bit = 0; bit < std::min<size_t>(64, block_last - word_first); ++bit)
+                    bits |= uint64_t{pred(first[word_first + bit]) ? 1u : 0u} << bit;
+
+                masks.mask[word_first / 64] = bits;
+                trues += std::bitset<64>(bits).count();
+            }
+            masks.trues_before[block] = trues;
+        });
+
+        std::exclusive_scan(masks.trues_before.begin(), masks.trues_before.end(), masks.trues_before.begin(), size_t{0});
+        return masks;
+    }
+
+    template <typename ExecutionPolicy, typename RandomAccessIterator, typename Predicate>
+    BlockMasks evaluate_blocks(ExecutionPolicy &&policy, RandomAccessIterator first, size_t size, Predicate pred, size_t block_size)
+    {
+        return evaluate_blocks_with(for_each_block_of(policy), first, size, pred, block_size);
+    }
+
+    // The elements in partitioned order - the trues of every block go after the trues of the blocks
+    // before it, its falses after all trues and the falses of the blocks before it
+    template <typename ForEachBlock, typename RandomAccessIterator>
+    auto scatter_blocks(ForEachBlock for_each_block, RandomAccessIterator first, size_t size, const BlockMasks &masks)
+    {
+        std::vector<typename std::iterator_traits<RandomAccessIterator>::value_type> buffer(size);
+        for_each_block(masks.blocks, [&](size_t block) {
+            const size_t block_first = block * masks.block_size;
+            const size_t block_last = std::min(size, block_first + masks.block_size);
+            size_t true_position = masks.trues_before[block];
+            size_t false_position = masks.total_trues() + block_first - masks.trues_before[block];
+
+            for (size_t i = block_first; i < block_last; ++i)
+                buffer[masks.is_true(i) ? true_position++ : false_position++] = std::move(first[i]);
+        });
+        return buffer;
+    }
+} // namespace stable_partition_detail
+
+// Stable partition in three passes: every block evaluates the predicate once per element into
+// a bitmask and counts its trues, a prefix sum of the counts gives every block its targets, then the
+// blocks scatter their elements into a buffer, which is moved back. Only the first pass calls the
+// predicate, so a costly predicate is spread over all blocks evenly.
+template <typename ExecutionPolicy, typename RandomAccessIterator, typename Predicate,
+    typename = std::enable_if_t<std::is_execution_policy_v<std::decay_t<ExecutionPolicy>>>>
+RandomAccessIterator blocked_stable_partition(ExecutionPolicy &&policy, RandomAccessIterator first, RandomAccessIterator last, Predicate pred, size_t block_size = 4096)
+{
+    const size_t size = std::distance(first, last);
+    const auto masks = stable_partition_detail::evaluate_blocks(policy, first, size, pred, block_size);
+    auto buffer = stable_partition_detail::scatter_blocks(stable_partition_detail::for_each_block_of(policy), first, size, masks);
+
+    std::move(policy, buffer.begin(), buffer.end(), first);
+    return first + masks.total_trues();
+}
+
+template <typename RandomAccessIterator, typename Predicate>
+RandomAccessIterator blocked_stable_partition(RandomAccessIterator first, RandomAccessIterator last, Predicate pred, size_t block_size = 4096)
+{
+    return blocked_stable_partition(std::execution::seq, first, last, pred, block_size);
+}
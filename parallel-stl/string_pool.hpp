@@ -0,0 +1,173 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <execution>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Words stored back to back in one character arena plus a dense array of (offset, length) entries
+class PooledDocumentContent
+{
+public:
+    struct Entry
+    {
+        std::uint64_t offset : 40;
+        std::uint64_t length : 24;
+    };
+
+    static constexpr size_t max_arena_size = size_t{1} << 40;
+    static constexpr size_t max_word_length = (size_t{1} << 24) - 1;
+
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = std::string_view;
+
+        const_iterator() = default;
+
+        const_iterator(const char *arena, const Entry *entry)
+            : arena_{arena}, entry_{entry}
+        {
+        }
+
+        std::string_view operator*() const noexcept
+        {
+            return {arena_ + entry_->offset, entry_->length};
+        }
+
+        std::string_view operator[](difference_type n) const noexcept
+        {
+            return *(*this + n);
+        }
+
+        const_iterator &operator++() noexcept { ++entry_; return *this; }
+        const_iterator operator++(int) noexcept { auto it = *this; ++entry_; return it; }
+        const_iterator &operator--() noexcept { --entry_; return *this; }
+        const_iterator operator--(int) noexcept { auto it = *this; --entry_; return it; }
+        const_iterator &operator+=(difference_type n) noexcept { entry_ += n; return *this; }
+        const_iterator &operator-=(difference_type n) noexcept { entry_ -= n; return *this; }
+
+        friend const_iterator operator+(const_iterator it, difference_type n) noexcept { return it += n; }
+        friend const_iterator operator+(difference_type n, const_iterator it) noexcept { return it += n; }
+        friend const_iterator operator-(const_iterator it, difference_type n) noexcept { return it -= n; }
+        friend difference_type operator-(const const_iterator &a, const const_iterator &b) noexcept { return a.entry_ - b.entry_; }
+
+        friend bool operator==(const const_iterator &a, const const_iterator &b) noexcept { return a.entry_ == b.entry_; }
+        friend bool operator!=(const const_iterator &a, const const_iterator &b) noexcept { return a.entry_ != b.entry_; }
+        friend bool operator<(const const_iterator &a, const const_iterator &b) noexcept { return a.entry_ < b.entry_; }
+        friend bool operator>(const const_iterator &a, const const_iterator &b) noexcept { return a.entry_ > b.entry_; }
+        friend bool operator<=(const const_iterator &a, const const_iterator &b) noexcept { return a.entry_ <= b.entry_; }
+        friend bool operator>=(const const_iterator &a, const const_iterator &b) noexcept { return a.entry_ >= b.entry_; }
+
+    private:
+        const char *arena_ = nullptr;
+        const Entry *entry_ = nullptr;
+    };
+
+    using value_type = std::string_view;
+    using iterator = const_iterator;
+
+    PooledDocumentContent() = default;
+
+    template <typename InputIterator>
+    PooledDocumentContent(InputIterator first, InputIterator last)
+    {
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<InputIterator>::iterator_category>)
+        {
+            size_t arena_size = 0;
+            for (auto it = first; it != last; ++it)
+                arena_size += std::string_view(*it).size();
+            reserve(std::distance(first, last), arena_size);
+        }
+
+        for (; first != last; ++first)
+            push_back(*first);
+    }
+
+    void reserve(size_t no_of_words, size_t arena_size)
+    {
+        entries_.reserve(no_of_words);
+        arena_.reserve(arena_size);
+    }
+
+    void push_back(std::string_view word)
+    {
+        if (word.size() > max_word_length || arena_.size() + word.size() > max_arena_size)
+            throw std::length_error("PooledDocumentContent - word does not fit in the arena");
+
+        entries_.push_back(Entry{arena_.size(), word.size()});
+        arena_.insert(arena_.end(), word.begin(), word.end());
+    }
+
+    std::string_view view(Entry entry) const noexcept
+    {
+        return {arena_.data() + entry.offset, entry.length};
+    }
+
+    std::string_view operator[](size_t index) const noexcept
+    {
+        return view(entries_[index]);
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return {arena_.data(), entries_.data()};
+    }
+
+    const_iterator end() const noexcept
+    {
+        return {arena_.data(), entries_.data() + entries_.size()};
+    }
+
+    size_t size() const noexcept
+    {
+        return entries_.size();
+    }
+
+    bool empty() const noexcept
+    {
+        return entries_.empty();
+    }
+
+    std::vector<Entry> &entries() noexcept
+    {
+        return entries_;
+    }
+
+    const std::vector<Entry> &entries() const noexcept
+    {
+        return entries_;
+    }
+
+    std::vector<char> &arena() noexcept
+    {
+        return arena_;
+    }
+
+    const std::vector<char> &arena() const noexcept
+    {
+        return arena_;
+    }
+
+    // Reorders only the entries - the arena is never touched
+    template <typename ExecutionPolicy, typename Compare = std::less<>>
+    void sort(ExecutionPolicy &&policy, Compare comp = {})
+    {
+        std::sort(std::forward<ExecutionPolicy>(policy), entries_.begin(), entries_.end(),
+            [this, comp](Entry a, Entry b) { return comp(view(a), view(b)); });
+    }
+
+private:
+    std::vector<char> arena_;
+    std::vector<Entry> entries_;
+};
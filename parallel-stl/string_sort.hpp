@@ -0,0 +1,184 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <execution>
+#include <iterator>
+#include <locale>
+#include <numeric>
+#include <thread>
+#include <utility>
+#include <vector>
+
+enum class CaseMode
+{
+    sensitive,
+    insensitive
+};
+
+namespace string_sort_detail
+{
+    using FoldTable = std::array<unsigned char, 256>;
+
+    constexpr size_t insertion_sort_threshold = 16;
+    constexpr size_t parallel_threshold = 16 * 1024;
+    constexpr size_t min_block_size = 4 * 1024;
+    constexpr size_t no_of_buckets = 257; // bucket 0 - strings shorter than the current depth
+
+    // Insensitive mode folds with the global locale the same way boost::to_lower does
+    inline const FoldTable &fold_table(CaseMode mode)
+    {
+        static const FoldTable identity = [] {
+            FoldTable table;
+            for (size_t c = 0; c < table.size(); ++c)
+                table[c] = static_cast<unsigned char>(c);
+            return table;
+        }();
+
+        static const FoldTable lower = [] {
+            const auto &char_type = std::use_facet<std::ctype<char>>(std::locale());
+            FoldTable table;
+            for (size_t c = 0; c < table.size(); ++c)
+                table[c] = static_cast<unsigned char>(char_type.tolower(static_cast<char>(c)));
+            return table;
+        }();
+
+        return mode == CaseMode::insensitive ? lower : identity;
+    }
+
+    template <typename String>
+    int key_at(const String &s, size_t depth, const FoldTable &fold) noexcept
+    {
+        return depth < s.size() ? fold[static_cast<unsigned char>(s[depth])] : -1;
+    }
+
+    template <typename String>
+    bool less_from(const String &a, const String &b, size_t depth, const FoldTable &fold) noexcept
+    {
+        for (;; ++depth)
+        {
+            int key_a = key_at(a, depth, fold);
+            int key_b = key_at(b, depth, fold);
+            if (key_a != key_b)
+                return key_a < key_b;
+            if (key_a == -1)
+                return false;
+        }
+    }
+
+    template <typename Iterator>
+    void insertion_sort(Iterator first, Iterator last, size_t depth, const FoldTable &fold)
+    {
+        if (first == last)
+            return;
+
+        for (auto i = std::next(first); i != last; ++i)
+            for (auto j = i; j != first && less_from(*j, *std::prev(j), depth, fold); --j)
+                std::iter_swap(j, std::prev(j));
+    }
+
+    // Bentley-Sedgewick three-way radix quicksort on the character at depth
+    template <typename Iterator>
+    void multikey_quicksort(Iterator first, Iterator last, size_t depth, const FoldTable &fold)
+    {
+        while (static_cast<size_t>(last - first) > insertion_sort_threshold)
+        {
+            int a = key_at(*first, depth, fold);
+            int b = key_at(first[(last - first) / 2], depth, fold);
+            int c = key_at(*std::prev(last), depth, fold);
+            int pivot = std::max(std::min(a, b), std::min(std::max(a, b), c));
+
+            Iterator lt = first, it = first, gt = last;
+            while (it != gt)
+            {
+                int key = key_at(*it, depth, fold);
+                if (key < pivot)
+                    std::iter_swap(lt++, it++);
+                else if (key > pivot)
+                    std::iter_swap(it, --gt);
+                else
+                    ++it;
+            }
+
+            multikey_quicksort(first, lt, depth, fold);
+            multikey_quicksort(gt, last, depth, fold);
+
+            if (pivot == -1)
+                return;
+
+            first = lt;
+            last = gt;
+            ++depth;
+        }
+
+        insertion_sort(first, last, depth, fold);
+    }
+
+    // Distributes the range into buckets by the character at depth (counted and scattered
+    // block-wise in parallel) and sorts the buckets in parallel
+    template <typename ExecutionPolicy, typename Iterator>
+    void msd_radix_sort(ExecutionPolicy &&policy, Iterator first, Iterator last, size_t depth, const FoldTable &fold)
+    {
+        const size_t size = last - first;
+
+        if (size < parallel_threshold)
+        {
+            multikey_quicksort(first, last, depth, fold);
+            return;
+        }
+
+        const size_t no_of_blocks = std::clamp<size_t>(size / min_block_size, 1, 4 * std::max(1u, std::thread::hardware_concurrency()));
+        auto block_begin = [&](size_t block) { return first + block * size / no_of_blocks; };
+
+        std::vector<size_t> blocks(no_of_blocks);
+        std::iota(blocks.begin(), blocks.end(), 0);
+
+        std::vector<std::array<size_t, no_of_buckets>> block_offsets(no_of_blocks);
+        std::for_each(policy, blocks.begin(), blocks.end(), [&](size_t block) {
+            auto &counts = block_offsets[block];
+            counts.fill(0);
+            std::for_each(block_begin(block), block_begin(block + 1), [&](const auto &s) { ++counts[key_at(s, depth, fold) + 1]; });
+        });
+
+        std::array<size_t, no_of_buckets + 1> bucket_begin;
+        size_t offset = 0;
+        for (size_t bucket = 0; bucket < no_of_buckets; ++bucket)
+        {
+            bucket_begin[bucket] = offset;
+            for (auto &counts : block_offsets)
+                offset += std::exchange(counts[bucket], offset);
+        }
+        bucket_begin[no_of_buckets] = size;
+
+        std::vector<typename std::iterator_traits<Iterator>::value_type> buffer(size);
+        std::for_each(policy, blocks.begin(), blocks.end(), [&](size_t block) {
+            auto &offsets = block_offsets[block];
+            std::for_each(block_begin(block), block_begin(block + 1), [&](auto &s) { buffer[offsets[key_at(s, depth, fold) + 1]++] = std::move(s); });
+        });
+        std::move(policy, buffer.begin(), buffer.end(), first);
+
+        std::vector<size_t> buckets;
+        for (size_t bucket = 1; bucket < no_of_buckets; ++bucket)
+            if (bucket_begin[bucket + 1] - bucket_begin[bucket] > 1)
+                buckets.push_back(bucket);
+
+        std::for_each(policy, buckets.begin(), buckets.end(), [&](size_t bucket) {
+            msd_radix_sort(policy, first + bucket_begin[bucket], first + bucket_begin[bucket + 1], depth + 1, fold);
+        });
+    }
+} // namespace string_sort_detail
+
+// Sorts std::string/std::string_view words by unsigned character values (the order of operator<).
+// CaseMode::insensitive gives the order of comparing boost::to_lower_copy of both words.
+template <typename ExecutionPolicy, typename String>
+void msd_sort(ExecutionPolicy &&policy, std::vector<String> &words, CaseMode mode = CaseMode::sensitive)
+{
+    string_sort_detail::msd_radix_sort(std::forward<ExecutionPolicy>(policy), words.begin(), words.end(), 0, string_sort_detail::fold_table(mode));
+}
+
+template <typename String>
+void msd_sort(std::vector<String> &words, CaseMode mode = CaseMode::sensitive)
+{
+    msd_sort(std::execution::seq, words, mode);
+}
@@ -0,0 +1,1514 @@
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "ascii_case.hpp"
+#include "benchmark_options.hpp"
+#include "benchmark_registry.hpp"
+#include "case_folding.hpp"
+#include "catch.hpp"
+#include "compaction.hpp"
+#include "concurrent_dedup.hpp"
+#include "external_sort.hpp"
+#include "fast_hash.hpp"
+#include "heavy_hitters.hpp"
+#include "intrinsics.hpp"
+#include "inverted_index.hpp"
+#include "latency_histogram.hpp"
+#include "loser_tree.hpp"
+#include "mapped_document.hpp"
+#include "measurement.hpp"
+#include "miller_rabin.hpp"
+#include "per_thread.hpp"
+#include "perf_counters.hpp"
+#include "pmr_document.hpp"
+#include "pool_algorithms.hpp"
+#include "prime_sieve.hpp"
+#include "scaling.hpp"
+#include "stable_partition.hpp"
+#include "string_pool.hpp"
+#include "string_sort.hpp"
+#include "thread_hooks.hpp"
+#include "tracing.hpp"
+#include "word_frequency.hpp"
+#include "word_pipeline.hpp"
+#include "zipf_corpus.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cctype>
+#include <cstdio>
+#include <execution>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace std::literals;
+
+TEST_CASE("tokenize")
+{
+    SECTION("splits on any whitespace")
+    {
+        auto tokens = tokenize(" one\ttwo\n\nthree\r\n four\v\ffive "sv);
+        REQUIRE(tokens == std::vector{"one"sv, "two"sv, "three"sv, "four"sv, "five"sv});
+    }
+
+    SECTION("empty or blank text")
+    {
+        REQUIRE(tokenize(""sv).empty());
+        REQUIRE(tokenize(" \n\t "sv).empty());
+    }
+
+    SECTION("tokens are views into the text")
+    {
+        std::string_view text = "abc def";
+        auto tokens = tokenize(text);
+        REQUIRE(tokens[1].data() == text.data() + 4);
+    }
+}
+
+TEST_CASE("tokenize - parallel")
+{
+    const std::string text = "  The  quick\tbrown fox\njumps over\n\nthe lazy dog  ";
+    const auto expected = tokenize(text);
+
+    for (size_t chunk_size : {1, 2, 3, 5, 8, 1000})
+    {
+        INFO("chunk size: " << chunk_size);
+        REQUIRE(tokenize(std::execution::par, text, chunk_size) == expected);
+    }
+
+    REQUIRE(tokenize(std::execution::par, ""sv).empty());
+}
+
+TEST_CASE("load_words_mapped")
+{
+    SECTION("missing file")
+    {
+        REQUIRE_FALSE(load_words_mapped("no_such_file.txt").has_value());
+    }
+
+    SECTION("words stay valid while the document lives")
+    {
+        const std::string file_name = "load_words_mapped_test.txt";
+        std::ofstream{file_name} << "Swann's Way\nby Marcel  Proust\n";
+
+        auto document = load_words_mapped(file_name);
+        std::remove(file_name.c_str());
+
+        REQUIRE(document.has_value());
+        auto moved_document = std::move(*document);
+        REQUIRE(moved_document.words() == std::vector{"Swann's"sv, "Way"sv, "by"sv, "Marcel"sv, "Proust"sv});
+    }
+}
+
+TEST_CASE("PooledDocumentContent")
+{
+    const std::vector<std::string> words = {"delta", "alpha", "a rather long word that does not fit in sso", "", "charlie"};
+
+    PooledDocumentContent pool{words.begin(), words.end()};
+
+    SECTION("iterates as string_views")
+    {
+        REQUIRE(pool.size() == words.size());
+        REQUIRE(std::equal(pool.begin(), pool.end(), words.begin(), words.end()));
+        REQUIRE(pool[2] == words[2]);
+        REQUIRE(pool.end() - pool.begin() == 5);
+    }
+
+    SECTION("characters are stored contiguously")
+    {
+        REQUIRE(pool.arena().size() == 60);
+        REQUIRE(pool[1].data() == pool[0].data() + 5);
+    }
+
+    SECTION("sort reorders entries only")
+    {
+        const auto arena = pool.arena();
+        pool.sort(std::execution::par);
+
+        auto sorted_words = words;
+        std::sort(sorted_words.begin(), sorted_words.end());
+
+        REQUIRE(std::equal(pool.begin(), pool.end(), sorted_words.begin(), sorted_words.end()));
+        REQUIRE(pool.arena() == arena);
+    }
+}
+
+TEST_CASE("sort_case_insensitive")
+{
+    const std::vector<std::string> words = {"banana", "Apple", "cherry", "apple", "BANANA", "Zebra", "zoo", "", "a", "Ant", "\xC3\xA9" "clair", "[bracket]"};
+    auto case_insensitive_less = [](const auto &a, const auto &b) { return boost::to_lower_copy(a) < boost::to_lower_copy(b); };
+
+    SECTION("strings")
+    {
+        auto sorted_words = words;
+        sort_case_insensitive(std::execution::par, sorted_words);
+
+        REQUIRE(std::is_sorted(sorted_words.begin(), sorted_words.end(), case_insensitive_less));
+        REQUIRE(std::is_permutation(sorted_words.begin(), sorted_words.end(), words.begin(), words.end()));
+    }
+
+    SECTION("string_views")
+    {
+        std::vector<std::string_view> sorted_words(words.begin(), words.end());
+        sort_case_insensitive(std::execution::seq, sorted_words);
+
+        auto expected_words = words;
+        std::sort(expected_words.begin(), expected_words.end(), case_insensitive_less);
+
+        for (size_t i = 0; i < words.size(); ++i)
+            REQUIRE(boost::to_lower_copy(std::string(sorted_words[i])) == boost::to_lower_copy(expected_words[i]));
+    }
+}
+
+TEST_CASE("msd_sort")
+{
+    std::mt19937_64 rnd_gen{42};
+    std::uniform_int_distribution<int> length_distr(0, 12);
+    std::uniform_int_distribution<int> char_distr(0, 7);
+    const std::string alphabet = "aAbBz\xE9\x80 ";
+
+    std::vector<std::string> words(100'000);
+    for (auto &word : words)
+    {
+        word = "prefix";
+        for (int length = length_distr(rnd_gen); length > 0; --length)
+            word += alphabet[char_distr(rnd_gen)];
+    }
+
+    SECTION("case sensitive order is the order of operator<")
+    {
+        auto expected = words;
+        std::sort(expected.begin(), expected.end());
+
+        auto sorted_words = words;
+        msd_sort(std::execution::par, sorted_words);
+        REQUIRE(sorted_words == expected);
+
+        std::vector<std::string_view> sorted_views(words.begin(), words.end());
+        msd_sort(sorted_views);
+        REQUIRE(std::equal(sorted_views.begin(), sorted_views.end(), expected.begin(), expected.end()));
+    }
+
+    SECTION("case insensitive order is the order of the to_lower_copy comparator")
+    {
+        auto sorted_words = words;
+        msd_sort(std::execution::par, sorted_words, CaseMode::insensitive);
+
+        REQUIRE(std::is_sorted(sorted_words.begin(), sorted_words.end(),
+            [](const auto &a, const auto &b) { return boost::to_lower_copy(a) < boost::to_lower_copy(b); }));
+
+        std::sort(sorted_words.begin(), sorted_words.end());
+        auto expected = words;
+        std::sort(expected.begin(), expected.end());
+        REQUIRE(sorted_words == expected);
+    }
+}
+
+TEST_CASE("to_lower_ascii")
+{
+    std::string ascii_text;
+    for (int i = 0; i < 300; ++i)
+        ascii_text += static_cast<char>(i % 128);
+
+    SECTION("matches boost::to_lower for every length and alignment")
+    {
+        for (size_t offset = 0; offset < 32; ++offset)
+            for (size_t length = 0; offset + length <= ascii_text.size(); length += 7)
+            {
+                std::string text = ascii_text.substr(offset, length);
+                std::string lowered(text.size(), '\0');
+
+                REQUIRE(to_lower_ascii(text.data(), text.data() + text.size(), lowered.data()));
+                REQUIRE(lowered == boost::to_lower_copy(text));
+
+                REQUIRE(to_lower_ascii(text.data(), text.data() + text.size()));
+                REQUIRE(text == lowered);
+            }
+    }
+
+    SECTION("reports non-ASCII bytes wherever they are")
+    {
+        for (size_t position = 0; position < 100; ++position)
+        {
+            std::string text = ascii_text.substr(0, 100);
+            text[position] = '\xC3';
+            REQUIRE_FALSE(to_lower_ascii(text.data(), text.data() + text.size()));
+        }
+    }
+
+    SECTION("to_lower_fast falls back to the locale path")
+    {
+        std::string text = "Cr\xC3\xA8me BR\xC3\xBBL\xC3\xA9" "E with a LONG ASCII TAIL OF UPPERCASE LETTERS";
+        std::string expected = boost::to_lower_copy(text);
+
+        to_lower_fast(text);
+        REQUIRE(text == expected);
+    }
+
+    SECTION("to_lower_fast in parallel chunks")
+    {
+        std::string text;
+        for (int i = 0; i < 50; ++i)
+            text += ascii_text + "Cr\xC3\xA8me BR\xC3\xBBL\xC3\xA9" "E";
+        std::string expected = boost::to_lower_copy(text);
+
+        to_lower_fast(std::execution::par, text, 1000);
+        REQUIRE(text == expected);
+    }
+}
+
+TEST_CASE("PrimeTable")
+{
+    auto is_prime_naive = [](uint64_t n) {
+        if (n < 2)
+            return false;
+        for (uint64_t d = 2; d * d <= n; ++d)
+            if (n % d == 0)
+                return false;
+        return true;
+    };
+
+    SECTION("small limits")
+    {
+        for (uint64_t limit : {0, 1, 2, 3, 4, 63, 64, 65, 127, 128, 129, 1000})
+        {
+            const PrimeTable primes{limit};
+            for (uint64_t n = 0; n <= limit; ++n)
+                REQUIRE(primes.is_prime(n) == is_prime_naive(n));
+        }
+    }
+
+    SECTION("table spanning many segments")
+    {
+        const uint64_t limit = 2'000'003;
+        const PrimeTable sequenced_primes{limit};
+        const PrimeTable parallel_primes{std::execution::par, limit};
+
+        REQUIRE(sequenced_primes.count() == 148'934);
+        REQUIRE(parallel_primes.count() == 148'934);
+
+        for (uint64_t n = limit - 10'000; n <= limit; ++n)
+            REQUIRE(parallel_primes.is_prime(n) == is_prime_naive(n));
+    }
+}
+
+TEST_CASE("is_prime_miller_rabin")
+{
+    SECTION("agrees with the sieve for small numbers")
+    {
+        const PrimeTable primes{1'000'000};
+        for (uint64_t n = 0; n <= primes.limit(); ++n)
+            REQUIRE(is_prime_miller_rabin(n) == primes.is_prime(n));
+    }
+
+    SECTION("64-bit primes and strong pseudoprimes")
+    {
+        REQUIRE(is_prime_miller_rabin(18'446'744'073'709'551'557ULL)); // largest 64-bit prime
+        REQUIRE(is_prime_miller_rabin(4'294'967'291ULL));
+        REQUIRE(is_prime_miller_rabin(1'000'000'000'000'000'003ULL));
+
+        REQUIRE_FALSE(is_prime_miller_rabin(18'446'744'073'709'551'615ULL));
+        REQUIRE_FALSE(is_prime_miller_rabin(4'294'967'291ULL * 4'294'967'279ULL));
+        REQUIRE_FALSE(is_prime_miller_rabin(3'215'031'751ULL));             // strong pseudoprime to bases 2, 3, 5, 7
+        REQUIRE_FALSE(is_prime_miller_rabin(3'825'123'056'546'413'051ULL)); // strong pseudoprime to bases 2 .. 23
+    }
+
+    SECTION("batched results match single tests")
+    {
+        std::mt19937_64 rnd_gen{665};
+        std::vector<uint64_t> candidates(10'003);
+        std::generate(candidates.begin(), candidates.end(), [&] { return rnd_gen() | 1; });
+        candidates[5] = 3'825'123'056'546'413'051ULL;
+        candidates[6] = 18'446'744'073'709'551'557ULL;
+        candidates[7] = 2;
+
+        std::vector<bool> expected;
+        std::transform(candidates.begin(), candidates.end(), std::back_inserter(expected), [](uint64_t n) { return is_prime_miller_rabin(n); });
+
+        std::vector<bool> sequenced_results;
+        is_prime_miller_rabin(candidates.begin(), candidates.end(), std::back_inserter(sequenced_results));
+        REQUIRE(sequenced_results == expected);
+
+        std::vector<uint64_t> parallel_results(candidates.size());
+        is_prime_miller_rabin(std::execution::par, candidates.begin(), candidates.end(), parallel_results.begin());
+        REQUIRE(std::equal(parallel_results.begin(), parallel_results.end(), expected.begin(), expected.end()));
+    }
+}
+
+TEST_CASE("fast_hash")
+{
+    std::string text;
+    for (int i = 0; i < 200; ++i)
+        text += static_cast<char>('a' + i * 7 % 26);
+
+    std::vector<std::string_view> keys;
+    for (size_t length = 0; length <= text.size(); ++length)
+        keys.push_back(std::string_view(text).substr(0, length));
+
+    SECTION("every prefix length gives a different hash")
+    {
+        std::vector<uint64_t> hashes;
+        std::transform(keys.begin(), keys.end(), std::back_inserter(hashes), [](std::string_view key) { return fast_hash(key); });
+        std::sort(hashes.begin(), hashes.end());
+        REQUIRE(std::adjacent_find(hashes.begin(), hashes.end()) == hashes.end());
+    }
+
+    SECTION("seed changes the hash")
+    {
+        REQUIRE(fast_hash("word"sv, 1) != fast_hash("word"sv, 2));
+        REQUIRE(fast_hash("word"sv) == fast_hash(std::string("word")));
+    }
+
+    SECTION("batched results match single hashes")
+    {
+        for (uint64_t seed : {0ULL, 42ULL})
+        {
+            std::vector<uint64_t> hashes;
+            fast_hash(keys.begin(), keys.end(), std::back_inserter(hashes), seed);
+
+            REQUIRE(hashes.size() == keys.size());
+            for (size_t i = 0; i < keys.size(); ++i)
+                REQUIRE(hashes[i] == fast_hash(keys[i], seed));
+        }
+    }
+}
+
+TEST_CASE("LatencyHistogram")
+{
+    SECTION("bucket bounds cover every value")
+    {
+        for (uint64_t value : {0ULL, 1ULL, 127ULL, 128ULL, 129ULL, 255ULL, 256ULL, 1'000'000ULL, 123'456'789'012ULL, ~0ULL})
+        {
+            const size_t index = LatencyHistogram::bucket_index(value);
+            REQUIRE(index < LatencyHistogram::no_of_buckets);
+            REQUIRE(LatencyHistogram::bucket_lower_bound(index) <= value);
+            REQUIRE(value <= LatencyHistogram::bucket_upper_bound(index));
+            REQUIRE(LatencyHistogram::bucket_upper_bound(index) - LatencyHistogram::bucket_lower_bound(index) <= value / 64);
+        }
+    }
+
+    SECTION("percentiles")
+    {
+        LatencyHistogram histogram;
+        for (uint64_t value = 1; value <= 10'000; ++value)
+            histogram.record(value * 1000);
+
+        REQUIRE(histogram.count() == 10'000);
+        REQUIRE(histogram.min() == 1000);
+        REQUIRE(histogram.max() == 10'000'000);
+        REQUIRE(histogram.percentile(50) == Approx(5'000'000).epsilon(0.02));
+        REQUIRE(histogram.percentile(99) == Approx(9'900'000).epsilon(0.02));
+        REQUIRE(histogram.percentile(99.9) == Approx(9'990'000).epsilon(0.02));
+        REQUIRE(histogram.percentile(100) == 10'000'000);
+    }
+
+    SECTION("merge and export")
+    {
+        LatencyHistogram a, b;
+        a.record(100, 3);
+        b.record(5000);
+        a.merge(b);
+
+        REQUIRE(a.count() == 4);
+        REQUIRE(a.max() == 5000);
+        REQUIRE(a.mean() == Approx(1325));
+
+        std::ostringstream out;
+        a.write_csv(out);
+        REQUIRE(out.str() == "lower_ns,upper_ns,count\n100,100,3\n4992,5055,1\n");
+    }
+}
+
+TEST_CASE("BenchmarkOptions::parse_list")
+{
+    REQUIRE(BenchmarkOptions::parse_list("1000,20000,300000") == std::vector<size_t>{1000, 20000, 300000});
+    REQUIRE(BenchmarkOptions::parse_list("4").size() == 1);
+    REQUIRE(BenchmarkOptions::parse_list(",1,,2,") == std::vector<size_t>{1, 2});
+    REQUIRE(BenchmarkOptions::parse_list("").empty());
+    REQUIRE_THROWS_AS(BenchmarkOptions::parse_list("1,two"), std::invalid_argument);
+}
+
+TEST_CASE("run_scaling_sweep")
+{
+    SECTION("default thread counts double up to the cores")
+    {
+        const auto threads = default_thread_counts();
+        REQUIRE(threads.front() == 1);
+        REQUIRE(threads.back() == std::max(1u, std::thread::hardware_concurrency()));
+        REQUIRE(std::is_sorted(threads.begin(), threads.end()));
+    }
+
+    SECTION("thread limits nest")
+    {
+        REQUIRE_FALSE(ThreadLimit::active());
+        {
+            ThreadLimit outer{4};
+            REQUIRE(ThreadLimit::active() == 4u);
+            {
+                ThreadLimit inner{2};
+                REQUIRE(ThreadLimit::active() == 2u);
+            }
+            REQUIRE(ThreadLimit::active() == 4u);
+        }
+        REQUIRE_FALSE(ThreadLimit::active());
+    }
+
+    SECTION("cases run under the limit of their point")
+    {
+        std::vector<size_t> limits;
+        const std::vector<ScalingCase> cases = {{"limited", [&](size_t) {
+            limits.push_back(ThreadLimit::active().value_or(0));
+            return std::chrono::nanoseconds(1000);
+        }}};
+
+        run_scaling_sweep(cases, {100}, {1, 2}, 1);
+        REQUIRE(limits == std::vector<size_t>{1, 1, 2, 2});
+    }
+
+    SECTION("median of the repetitions")
+    {
+        std::vector<std::chrono::nanoseconds> times = {5ms, 1ms, 3ms};
+        size_t next = 0;
+        const ScalingCase scaling_case{"case", [&](size_t) { return times[next++]; }};
+
+        REQUIRE(median_ms(scaling_case, 100, 3) == Approx(3));
+        REQUIRE(next == 3);
+    }
+
+    SECTION("strong and weak points relate to the first thread count")
+    {
+        // time proportional to the size, whatever the thread count
+        std::vector<size_t> sizes_run;
+        const std::vector<ScalingCase> cases = {{"linear", [&](size_t size) {
+            sizes_run.push_back(size);
+            return std::chrono::nanoseconds(size * 1000);
+        }}};
+
+        const auto points = run_scaling_sweep(cases, {100}, {1, 2, 4}, 2);
+        REQUIRE(points.size() == 6);
+        REQUIRE(sizes_run.size() == 12);
+
+        for (const auto &point : points)
+        {
+            const size_t scale = point.threads;
+            REQUIRE(point.name == "linear");
+            if (point.mode == "strong")
+            {
+                REQUIRE(point.size == 100);
+                REQUIRE(point.median_ms == Approx(0.1));
+                REQUIRE(point.speedup == Approx(1));
+                REQUIRE(point.efficiency == Approx(1.0 / scale));
+            }
+            else
+            {
+                REQUIRE(point.mode == "weak");
+                REQUIRE(point.size == 100 * scale);
+                REQUIRE(point.median_ms == Approx(0.1 * scale));
+                REQUIRE(point.efficiency == Approx(1.0 / scale));
+                REQUIRE(point.speedup == Approx(1));
+            }
+        }
+    }
+
+    SECTION("csv and json")
+    {
+        const std::vector<ScalingPoint> points = {{"strong", "sort - parallel", 2, 1000, 1.5, 1.75, 0.875}, {"weak", "sort - parallel", 2, 2000, 3, 1, 0.5}};
+
+        std::ostringstream csv;
+        write_csv(csv, points);
+        REQUIRE(csv.str() == "mode,case,threads,size,median_ms,speedup,efficiency\n"
+                             "strong,\"sort - parallel\",2,1000,1.5,1.75,0.875\n"
+                             "weak,\"sort - parallel\",2,2000,3,1,0.5\n");
+
+        std::ostringstream json;
+        write_json(json, points);
+        REQUIRE(json.str() == "[\n"
+                              "  {\"mode\": \"strong\", \"case\": \"sort - parallel\", \"threads\": 2, \"size\": 1000, \"median_ms\": 1.5, \"speedup\": 1.75, \"efficiency\": 0.875},\n"
+                              "  {\"mode\": \"weak\", \"case\": \"sort - parallel\", \"threads\": 2, \"size\": 2000, \"median_ms\": 3, \"speedup\": 1, \"efficiency\": 0.5}\n"
+                              "]\n");
+    }
+}
+
+TEST_CASE("BenchmarkGroup")
+{
+    std::vector<std::pair<size_t, int>> prepared;
+    std::vector<int> calls;
+
+    const auto registered_before = BenchmarkGroup::all().size();
+    {
+        const BenchmarkGroup group{"group", {
+            {"sized", [&](size_t size) {
+                 prepared.emplace_back(size, 0);
+                 return [&, size] { calls.push_back(static_cast<int>(size)); return size; };
+             }},
+            BenchmarkCase{"per run", [&](size_t size, int runs) {
+                 prepared.emplace_back(size, runs);
+                 return [&](int run) { calls.push_back(run); };
+             }, 1}.with_counters(),
+        }};
+
+        REQUIRE(BenchmarkGroup::all().size() == registered_before + 1);
+        REQUIRE(BenchmarkGroup::all().back() == &group);
+        REQUIRE(group.cases()[0].elements == std::nullopt);
+        REQUIRE(group.cases()[1].elements == 1);
+        REQUIRE_FALSE(group.cases()[0].counters);
+        REQUIRE(group.cases()[1].counters);
+
+        SECTION("prepare and call")
+        {
+            auto call = group.cases()[1].prepare(10, 3);
+            call(0);
+            call(2);
+            REQUIRE(prepared == std::vector<std::pair<size_t, int>>{{10, 3}});
+            REQUIRE(calls == std::vector<int>{0, 2});
+        }
+
+        SECTION("scaling cases of every case")
+        {
+            const auto cases = group.scaling_cases();
+            REQUIRE(cases.size() == 2);
+            REQUIRE(cases[0].name == "group - sized");
+            REQUIRE(cases[1].name == "group - per run");
+
+            cases[0].run(7);
+            cases[1].run(5);
+            REQUIRE(prepared == std::vector<std::pair<size_t, int>>{{7, 0}, {5, 1}});
+            REQUIRE(calls == std::vector<int>{7, 0});
+
+            const auto all_cases = BenchmarkGroup::all_scaling_cases();
+            REQUIRE(std::count_if(all_cases.begin(), all_cases.end(), [](const auto &c) { return c.name.rfind("group - ", 0) == 0; }) == 2);
+        }
+    }
+    REQUIRE(BenchmarkGroup::all().size() == registered_before);
+}
+
+TEST_CASE("PerfCounters")
+{
+    REQUIRE(perf_event_name(PerfEvent::cycles) == "cycles"s);
+    REQUIRE(perf_event_name(PerfEvent::branch_misses) == "branch misses"s);
+
+#ifdef PSTL_HAS_PERF_EVENTS
+    SECTION("a thread's group counts or says why it cannot")
+    {
+        const ThreadCounterGroup group;
+        PerfSnapshot before;
+        group.add_to(before);
+
+        volatile uint64_t sum = 0;
+        for (uint64_t i = 0; i < 1'000'000; ++i)
+            sum = sum + i;
+
+        PerfSnapshot after;
+        group.add_to(after);
+
+        if (group.opened_events().empty())
+        {
+            REQUIRE_FALSE(group.error().empty());
+            REQUIRE(after.values == PerfSnapshot{}.values);
+        }
+        else
+        {
+            for (PerfEvent event : group.opened_events())
+                REQUIRE(after.values[static_cast<size_t>(event)] >= before.values[static_cast<size_t>(event)]);
+        }
+    }
+
+    SECTION("a group of another thread keeps its counts after the thread ended")
+    {
+        std::atomic<pid_t> tid{0};
+        std::atomic<bool> counting{false};
+        std::thread thd{[&] {
+            tid = static_cast<pid_t>(::syscall(SYS_gettid));
+            while (!counting)
+                std::this_thread::yield();
+
+            volatile uint64_t sum = 0;
+            for (uint64_t i = 0; i < 1'000'000; ++i)
+                sum = sum + i;
+        }};
+
+        while (tid == 0)
+            std::this_thread::yield();
+        const ThreadCounterGroup group{tid};
+        counting = true;
+        thd.join();
+
+        PerfSnapshot after;
+        group.add_to(after);
+        if (group.opened_events().empty())
+            REQUIRE_FALSE(group.error().empty());
+        else
+            REQUIRE(after.values[static_cast<size_t>(group.opened_events().front())] > 0);
+    }
+#endif
+
+    SECTION("disabled counters are unavailable")
+    {
+        PerfCounters &counters = PerfCounters::instance();
+        if (!counters.enabled())
+        {
+            counters.register_current_thread();
+            REQUIRE_FALSE(counters.any_available());
+            REQUIRE(counters.snapshot().values == PerfSnapshot{}.values);
+        }
+    }
+}
+
+TEST_CASE("PerfCountersScope")
+{
+    PerfCounters &counters = PerfCounters::instance();
+    const bool were_enabled = counters.enabled();
+    {
+        PerfCountersScope scope;
+        REQUIRE(counters.enabled());
+    }
+    REQUIRE(counters.enabled() == were_enabled);
+}
+
+TEST_CASE("ThreadStartHooks")
+{
+    static std::atomic<int> starts{0};
+    static thread_local bool started = false;
+    ThreadStartHooks::add([] {
+        started = true;
+        ++starts;
+    });
+
+    const int starts_before = starts;
+    {
+        WorkStealingPool pool{2};
+        TaskGroup group{pool};
+        group.run([] {});
+        group.wait();
+    }
+    REQUIRE(starts - starts_before == 2);
+
+    std::atomic<bool> started_in_stage{false};
+    BoundedQueue<int> items{4};
+    Pipeline pipeline;
+    pipeline.add_source(items, [](auto emit) { emit(1); });
+    pipeline.add_sink(items, 1, [&](int) { started_in_stage = started; });
+    pipeline.wait();
+    REQUIRE(started_in_stage);
+    REQUIRE(starts - starts_before == 4);
+    REQUIRE_FALSE(started);
+}
+
+TEST_CASE("MeasurementListener")
+{
+    Measurements &measurements = Measurements::instance();
+    const bool histograms_were_enabled = measurements.histograms_enabled();
+    const std::string histogram_directory = measurements.histogram_directory();
+
+    const auto directory = std::filesystem::temp_directory_path() / ("pstl-histograms-" + std::to_string(std::random_device{}()));
+    std::filesystem::create_directory(directory);
+    measurements.enable_histograms(directory.string());
+
+    std::ostringstream report;
+    MeasurementListener listener{Catch::ReporterConfig{Catch::getCurrentContext().getConfig(), report}};
+    const Catch::BenchmarkInfo info{"measured benchmark", 0, 4, 2, 0, 0, 0};
+
+    {
+        MeasurementScope before_start{10, 4};
+    }
+
+    listener.benchmarkStarting(info);
+    for (int sample = 0; sample < 2; ++sample)
+    {
+        MeasurementScope measurement{10, 4};
+        REQUIRE(measurement.times_calls());
+        for (int call = 0; call < 4; ++call)
+            measurement.time_call([&] { std::this_thread::sleep_for(sample == 1 && call == 3 ? 8ms : 1ms); });
+    }
+    listener.benchmarkEnded(Catch::BenchmarkStats<>{info, {}, {}, {}, {}, 0});
+
+    {
+        MeasurementScope after_end{10, 4};
+    }
+
+    SECTION("every call of the samples, nothing outside")
+    {
+        const auto benchmarks = measurements.take_benchmarks();
+        REQUIRE(benchmarks.size() == 1);
+        REQUIRE(benchmarks[0].name == "measured benchmark");
+        REQUIRE(benchmarks[0].calls == 8);
+        REQUIRE(benchmarks[0].elements == 80);
+        REQUIRE(benchmarks[0].latencies.count() == 8);
+        REQUIRE(benchmarks[0].latencies.min() >= 1'000'000);
+        REQUIRE(benchmarks[0].latencies.percentile(50) < 8'000'000);
+        REQUIRE(benchmarks[0].latencies.max() >= 8'000'000);
+    }
+
+    SECTION("histograms exported at the end of the test case")
+    {
+        listener.testCaseEnded(Catch::TestCaseStats{
+            Catch::TestCaseInfo{"measured test", "", "", {}, CATCH_INTERNAL_LINEINFO}, Catch::Totals{}, "", "", false});
+        REQUIRE(measurements.take_benchmarks().empty());
+
+        std::ifstream histogram{directory / "measured_test.measured_benchmark.csv"};
+        REQUIRE(histogram);
+        std::string header;
+        std::getline(histogram, header);
+        REQUIRE(header == "lower_ns,upper_ns,count");
+    }
+
+    std::filesystem::remove_all(directory);
+    if (histograms_were_enabled)
+        measurements.enable_histograms(histogram_directory);
+    else
+        measurements.disable_histograms();
+}
+
+TEST_CASE("trace::Zone")
+{
+    const bool was_enabled = trace::enabled();
+    trace::enable();
+
+    {
+        trace::Zone outer{"outer \"zone\""};
+        std::thread thd{[] { trace::Zone inner{"inner zone"}; }};
+        thd.join();
+    }
+
+    std::ostringstream out;
+    trace::write_chrome_trace(out);
+    const std::string json = out.str();
+
+    REQUIRE(json.find(R"("name":"outer \"zone\"","ph":"X")") != std::string::npos);
+    REQUIRE(json.find(R"("name":"inner zone","ph":"X")") != std::string::npos);
+    REQUIRE(json.find(R"("name":"thread_name")") != std::string::npos);
+
+    if (!was_enabled)
+    {
+        trace::disable();
+        trace::clear();
+
+        {
+            trace::Zone zone{"not recorded"};
+        }
+
+        std::ostringstream cleared;
+        trace::write_chrome_trace(cleared);
+        REQUIRE(cleared.str().find("zone") == std::string::npos);
+    }
+}
+
+TEST_CASE("ZipfCorpus")
+{
+    CorpusSettings settings;
+    settings.vocabulary_size = 1000;
+    settings.seed = 7;
+    const ZipfCorpus corpus{settings};
+
+    SECTION("vocabulary")
+    {
+        REQUIRE(corpus.vocabulary().size() == 1000);
+        REQUIRE(std::all_of(corpus.vocabulary().begin(), corpus.vocabulary().end(), [&](const auto &word) {
+            return !word.empty() && word.size() < settings.length_weights.size() && std::all_of(word.begin(), word.end(), [](char c) { return c >= 'a' && c <= 'z'; });
+        }));
+    }
+
+    SECTION("same seed - same words, regardless of the policy")
+    {
+        const auto words = corpus.generate_words(200'000);
+        REQUIRE(words == ZipfCorpus{settings}.generate_words(std::execution::par, 200'000));
+
+        settings.seed = 8;
+        REQUIRE(words != ZipfCorpus{settings}.generate_words(200'000));
+    }
+
+    SECTION("frequencies follow the ranks")
+    {
+        const auto words = corpus.generate_words(200'000);
+
+        auto occurrences = [&](size_t rank) {
+            const std::string &word = corpus.vocabulary()[rank];
+            return std::count_if(words.begin(), words.end(), [&](const auto &w) { return w.size() == word.size() && boost::iequals(w, word); });
+        };
+
+        const double first = static_cast<double>(occurrences(0));
+        REQUIRE(first / occurrences(1) == Approx(2.0).epsilon(0.1));
+        REQUIRE(first / occurrences(9) == Approx(10.0).epsilon(0.15));
+    }
+
+    SECTION("vocabulary larger than the word lengths allow")
+    {
+        CorpusSettings short_words;
+        short_words.vocabulary_size = 100;
+        short_words.length_weights = {0, 1.0};
+        REQUIRE_THROWS_AS(ZipfCorpus{short_words}, std::invalid_argument);
+    }
+
+    SECTION("file of an exact size")
+    {
+        const std::string file_name = "zipf_corpus_test.txt";
+        REQUIRE(corpus.write_file(std::execution::par, file_name, 5'000'000, 2));
+
+        const auto corpus_words = load_words_mapped(file_name);
+        REQUIRE(corpus_words);
+        REQUIRE(corpus_words->text().size() == 5'000'000);
+        REQUIRE(corpus_words->text().back() == '\n');
+
+        std::string prefix(corpus_words->text().substr(0, 1'000'000));
+        REQUIRE(prefix.find("\n\n") == std::string::npos);
+
+        // no word is cut at the end of a block
+        const std::unordered_set<std::string> vocabulary(corpus.vocabulary().begin(), corpus.vocabulary().end());
+        REQUIRE(std::all_of(corpus_words->begin(), corpus_words->end(), [&](std::string_view word) { return vocabulary.count(boost::to_lower_copy(std::string{word})) == 1; }));
+
+        std::remove(file_name.c_str());
+    }
+}
+
+TEST_CASE("count_words")
+{
+    CorpusSettings settings;
+    settings.vocabulary_size = 5000;
+    const auto words = ZipfCorpus{settings}.generate_words(100'000);
+
+    std::unordered_map<std::string_view, uint64_t> expected;
+    for (const auto &word : words)
+        ++expected[word];
+
+    SECTION("sequenced and parallel agree with std::unordered_map")
+    {
+        for (const auto &frequencies : {count_words(words.begin(), words.end()), count_words(std::execution::par, words.begin(), words.end(), 1000)})
+        {
+            REQUIRE(frequencies.size() == expected.size());
+            REQUIRE(std::all_of(expected.begin(), expected.end(), [&](const auto &item) { return frequencies.count(item.first) == item.second; }));
+            REQUIRE(frequencies.count("not a word") == 0);
+        }
+    }
+
+    SECTION("most frequent")
+    {
+        const auto top = count_words(std::execution::par, words.begin(), words.end()).most_frequent(3);
+
+        REQUIRE(top.size() == 3);
+        REQUIRE(top[0].second >= top[1].second);
+        REQUIRE(top[1].second >= top[2].second);
+        REQUIRE(top[0].second == expected[top[0].first]);
+    }
+
+    SECTION("empty input")
+    {
+        const std::vector<std::string> no_words;
+        REQUIRE(count_words(std::execution::par, no_words.begin(), no_words.end()).size() == 0);
+    }
+}
+
+TEST_CASE("unique_words")
+{
+    CorpusSettings settings;
+    settings.vocabulary_size = 20'000;
+    const auto words = ZipfCorpus{settings}.generate_words(100'000);
+
+    std::vector<std::string_view> expected;
+    std::unordered_set<std::string_view> seen;
+    for (const auto &word : words)
+    {
+        if (seen.insert(word).second)
+            expected.push_back(word);
+    }
+
+    SECTION("views of the first occurrences")
+    {
+        const auto unique = unique_words(std::execution::par, words.begin(), words.end(), 1000);
+
+        REQUIRE(unique == expected);
+        REQUIRE(unique.front().data() == words.front().data());
+        REQUIRE(unique_words(words.begin(), words.end()) == expected);
+    }
+
+    SECTION("moved strings")
+    {
+        auto to_dedup = words;
+        const auto unique = unique_words(std::execution::par, std::move(to_dedup));
+
+        REQUIRE(std::equal(unique.begin(), unique.end(), expected.begin(), expected.end()));
+        REQUIRE(to_dedup.empty());
+    }
+
+    SECTION("empty input")
+    {
+        const std::vector<std::string> no_words;
+        REQUIRE(unique_words(std::execution::par, no_words.begin(), no_words.end()).empty());
+    }
+}
+
+TEST_CASE("LoserTree")
+{
+    const std::vector<std::vector<int>> sources = {{1, 4, 9}, {}, {2, 3, 10, 11}, {4}, {0, 12}};
+
+    std::vector<size_t> positions(sources.size());
+    std::vector<std::optional<int>> heads;
+    for (const auto &source : sources)
+        heads.push_back(source.empty() ? std::nullopt : std::optional{source.front()});
+
+    LoserTree<int> tree{heads};
+    std::vector<std::pair<int, size_t>> merged;
+    while (!tree.empty())
+    {
+        const size_t source = tree.top_source();
+        merged.emplace_back(tree.top(), source);
+
+        const auto &values = sources[source];
+        tree.replace_top(++positions[source] < values.size() ? std::optional{values[positions[source]]} : std::nullopt);
+    }
+
+    const std::vector<std::pair<int, size_t>> expected = {{0, 4}, {1, 0}, {2, 2}, {3, 2}, {4, 0}, {4, 3}, {9, 0}, {10, 2}, {11, 2}, {12, 4}};
+    REQUIRE(merged == expected);
+
+    REQUIRE(LoserTree<int>{{}}.empty());
+}
+
+TEST_CASE("external_sort")
+{
+    const std::string input_file = "external_sort_input.txt";
+    const std::string output_file = "external_sort_output.txt";
+    REQUIRE(ZipfCorpus{}.write_file(input_file, 300'000));
+
+    ExternalSortSettings settings;
+    settings.run_bytes = 16 * 1024;
+    settings.buffer_bytes = 1024;
+    settings.max_fan_in = 4;
+    settings.temp_directory = ".";
+
+    const auto input_words = load_words_mapped(input_file).value();
+    auto expected = input_words.words();
+    std::sort(expected.begin(), expected.end());
+
+    for (const auto &stats : {external_sort(input_file, output_file, settings), external_sort(std::execution::par, input_file, output_file, settings)})
+    {
+        REQUIRE(stats);
+        REQUIRE(stats->no_of_words == expected.size());
+        REQUIRE(stats->no_of_runs == 19);
+        REQUIRE(stats->no_of_merge_passes == 3);
+
+        const auto sorted = load_words_mapped(output_file).value();
+        REQUIRE(sorted.words() == expected);
+    }
+
+    SECTION("the merge memory limits the fan-in")
+    {
+        settings.merge_memory_bytes = 3 * settings.buffer_bytes;
+        const auto stats = external_sort(std::execution::par, input_file, output_file, settings);
+        REQUIRE(stats);
+        REQUIRE(stats->no_of_runs == 19);
+        REQUIRE(stats->no_of_merge_passes == 5);
+        REQUIRE(load_words_mapped(output_file).value().words() == expected);
+    }
+
+    REQUIRE_FALSE(external_sort("no_such_file.txt", output_file));
+
+    std::remove(input_file.c_str());
+    std::remove(output_file.c_str());
+}
+
+TEST_CASE("SpaceSaving")
+{
+    CorpusSettings settings;
+    settings.vocabulary_size = 20'000;
+    const auto words = ZipfCorpus{settings}.generate_words(200'000);
+
+    std::unordered_map<std::string_view, uint64_t> exact;
+    for (const auto &word : words)
+        ++exact[word];
+
+    std::vector<std::pair<std::string_view, uint64_t>> exact_top(exact.begin(), exact.end());
+    std::sort(exact_top.begin(), exact_top.end(), [](const auto &a, const auto &b) { return a.second > b.second; });
+
+    constexpr size_t capacity = 500;
+
+    auto check_bounds = [&](const SpaceSaving &sketch) {
+        REQUIRE(sketch.total_count() == words.size());
+        REQUIRE(sketch.max_error() <= words.size() / capacity);
+
+        const auto top = sketch.top(capacity);
+        REQUIRE(top.size() == capacity);
+        for (const auto &hitter : top)
+        {
+            REQUIRE(hitter.guaranteed_count() <= exact[hitter.word]);
+            REQUIRE(exact[hitter.word] <= hitter.count);
+            REQUIRE(hitter.error <= sketch.max_error());
+        }
+
+        const auto top_5 = sketch.top(5);
+        for (size_t i = 0; i < top_5.size(); ++i)
+            REQUIRE(top_5[i].word == exact_top[i].first);
+    };
+
+    SECTION("sequenced")
+    {
+        check_bounds(heavy_hitters(words.begin(), words.end(), capacity));
+    }
+
+    SECTION("parallel - merged sketches")
+    {
+        check_bounds(heavy_hitters(std::execution::par, words.begin(), words.end(), capacity, 10'000));
+    }
+
+    SECTION("below capacity - exact")
+    {
+        const std::vector<std::string> few_words = {"a", "b", "a", "c", "a", "b"};
+        const auto top = heavy_hitters(few_words.begin(), few_words.end(), 10).top(2);
+
+        REQUIRE(top.size() == 2);
+        REQUIRE(top[0].word == "a");
+        REQUIRE(top[0].count == 3);
+        REQUIRE(top[0].error == 0);
+        REQUIRE(top[1].word == "b");
+        REQUIRE(top[1].count == 2);
+    }
+}
+
+TEST_CASE("varbyte")
+{
+    const std::vector<uint32_t> values = {0, 1, 127, 128, 300, 16'383, 16'384, 1'000'000, 4'294'967'295};
+
+    const auto bytes = varbyte::encode_deltas(values.begin(), values.end());
+    REQUIRE(bytes.size() == 1 + 1 + 1 + 1 + 2 + 2 + 1 + 3 + 5);
+
+    varbyte::DeltaCursor cursor{bytes.data(), values.size()};
+    std::vector<uint32_t> decoded;
+    while (!cursor.done())
+        decoded.push_back(cursor.next());
+    REQUIRE(decoded == values);
+}
+
+TEST_CASE("InvertedIndex")
+{
+    const std::vector<std::string> text = {"to", "be", "or", "not", "to", "be", "that", "is", "the", "question", "to", "be"};
+    const InvertedIndex index{std::execution::par, text.begin(), text.end()};
+
+    REQUIRE(index.no_of_terms() == 8);
+    REQUIRE(index.frequency("to") == 3);
+    REQUIRE(index.frequency("hamlet") == 0);
+    REQUIRE(index.positions("be") == std::vector<uint32_t>{1, 5, 11});
+    REQUIRE(index.positions("hamlet").empty());
+
+    REQUIRE(index.phrase({"to", "be"}) == std::vector<uint32_t>{0, 4, 10});
+    REQUIRE(index.phrase({"to", "be", "or"}) == std::vector<uint32_t>{0});
+    REQUIRE(index.phrase({"be", "to"}).empty());
+    REQUIRE(index.phrase({"to", "hamlet"}).empty());
+
+    SECTION("same as a linear scan on a large corpus")
+    {
+        const ZipfCorpus corpus;
+        const auto words = corpus.generate_words(200'000);
+        const InvertedIndex corpus_index{std::execution::par, words.begin(), words.end()};
+        const InvertedIndex sequenced_index{words.begin(), words.end()};
+
+        const std::vector<std::string_view> query = {corpus.vocabulary()[0], corpus.vocabulary()[1]};
+        std::vector<uint32_t> expected;
+        for (size_t i = 0; i + 1 < words.size(); ++i)
+        {
+            if (words[i] == query[0] && words[i + 1] == query[1])
+                expected.push_back(static_cast<uint32_t>(i));
+        }
+
+        REQUIRE_FALSE(expected.empty());
+        REQUIRE(corpus_index.phrase(query) == expected);
+        REQUIRE(sequenced_index.phrase(query) == expected);
+        REQUIRE(corpus_index.no_of_bytes() < words.size() * 2);
+    }
+}
+
+TEST_CASE("Pipeline")
+{
+    SECTION("every item passes all stages")
+    {
+        BoundedQueue<int> numbers{2};
+        BoundedQueue<long> squares{2};
+        std::atomic<long> sum = 0;
+
+        Pipeline pipeline;
+        pipeline.add_source(numbers, [](auto emit) {
+            for (int i = 1; i <= 1000; ++i)
+                emit(i);
+        });
+        pipeline.add_stage(numbers, squares, 3, [](int n) { return static_cast<long>(n) * n; });
+        pipeline.add_sink(squares, 2, [&](long square) { sum += square; });
+        pipeline.wait();
+
+        REQUIRE(sum == 1000L * 1001 * 2001 / 6);
+    }
+
+    SECTION("an exception stops the pipeline")
+    {
+        BoundedQueue<int> numbers{2};
+        BoundedQueue<int> results{2};
+
+        Pipeline pipeline;
+        pipeline.add_source(numbers, [](auto emit) {
+            for (int i = 0; emit(i); ++i)
+                ;
+        });
+        pipeline.add_stage(numbers, results, 2, [](int n) {
+            if (n == 100)
+                throw std::runtime_error("stage failed");
+            return n;
+        });
+        pipeline.add_sink(results, 1, [](int) {});
+
+        REQUIRE_THROWS_AS(pipeline.wait(), std::runtime_error);
+    }
+}
+
+TEST_CASE("sort_runs_pipelined")
+{
+    const std::string file_name = "word_pipeline_input.txt";
+    REQUIRE(ZipfCorpus{}.write_file(file_name, 500'000));
+
+    WordPipelineSettings settings;
+    settings.chunk_bytes = 10'000;
+    settings.normalize_threads = 2;
+    settings.sort_threads = 3;
+
+    const auto result = sort_runs_pipelined(file_name, settings);
+    REQUIRE(result);
+    REQUIRE(result->runs.size() == 50);
+    REQUIRE(result->time_to_first_run <= result->total_time);
+
+    const auto input_words = load_words_mapped(file_name).value();
+    std::vector<std::string> expected(input_words.begin(), input_words.end());
+    for (auto &word : expected)
+        boost::to_lower(word);
+    std::sort(expected.begin(), expected.end());
+
+    const auto merged = merge_sorted_runs(result->runs);
+    REQUIRE(std::equal(merged.begin(), merged.end(), expected.begin(), expected.end()));
+
+    REQUIRE_FALSE(sort_runs_pipelined("no_such_file.txt"));
+    std::remove(file_name.c_str());
+}
+
+TEST_CASE("WorkStealingPool")
+{
+    WorkStealingPool pool{3};
+    REQUIRE(pool.size() == 3);
+
+    SECTION("tasks of nested groups")
+    {
+        std::atomic<int> count{0};
+        TaskGroup group{pool};
+        for (int i = 0; i < 10; ++i)
+        {
+            group.run([&] {
+                TaskGroup inner{pool};
+                for (int j = 0; j < 100; ++j)
+                    inner.run([&] { ++count; });
+                inner.wait();
+            });
+        }
+        group.wait();
+
+        REQUIRE(count == 1000);
+    }
+
+    SECTION("exception")
+    {
+        TaskGroup group{pool};
+        group.run([] { throw std::runtime_error("task failed"); });
+        group.run([] {});
+
+        REQUIRE_THROWS_AS(group.wait(), std::runtime_error);
+        REQUIRE_NOTHROW(group.wait());
+    }
+
+    SECTION("affinity")
+    {
+        REQUIRE(pool.affinity() == Affinity::none);
+
+        WorkStealingPool pinned{3, Affinity::pinned};
+        REQUIRE(pinned.affinity() == Affinity::pinned);
+
+        std::atomic<int> count{0};
+        TaskGroup group{pinned};
+        for (int i = 0; i < 100; ++i)
+            group.run([&] { ++count; });
+        group.wait();
+        REQUIRE(count == 100);
+    }
+}
+
+TEST_CASE("pool algorithms")
+{
+    WorkStealingPool pool{4};
+    const pstl::PoolPolicy policy{pool, 100};
+
+    std::vector<int> numbers(100'000);
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<int> distribution{0, 1000};
+    std::generate(numbers.begin(), numbers.end(), [&] { return distribution(gen); });
+
+    SECTION("for_each")
+    {
+        auto doubled = numbers;
+        pstl::for_each(policy, doubled.begin(), doubled.end(), [](int &n) { n *= 2; });
+        REQUIRE(std::equal(doubled.begin(), doubled.end(), numbers.begin(), [](int a, int b) { return a == 2 * b; }));
+    }
+
+    SECTION("transform")
+    {
+        std::vector<long> squares(numbers.size());
+        REQUIRE(pstl::transform(policy, numbers.begin(), numbers.end(), squares.begin(), [](int n) { return long{n} * n; }) == squares.end());
+
+        std::vector<long> expected(numbers.size());
+        std::transform(numbers.begin(), numbers.end(), expected.begin(), [](int n) { return long{n} * n; });
+        REQUIRE(squares == expected);
+    }
+
+    SECTION("transform_reduce")
+    {
+        const auto expected = std::accumulate(numbers.begin(), numbers.end(), 0L);
+        REQUIRE(pstl::transform_reduce(policy, numbers.begin(), numbers.end(), 0L, std::plus{}, [](int n) { return long{n}; }) == expected);
+        REQUIRE(pstl::transform_reduce(pstl::PoolPolicy{pool}, numbers.begin(), numbers.end(), 0L, std::plus{}, [](int n) { return long{n}; }) == expected);
+
+        const std::vector<int> empty;
+        REQUIRE(pstl::transform_reduce(policy, empty.begin(), empty.end(), 7L, std::plus{}, [](int n) { return long{n}; }) == 7);
+
+        // combined in order - concatenation is not commutative
+        std::vector<std::string> letters;
+        for (char c = 'a'; c <= 'z'; ++c)
+            letters.emplace_back(1, c);
+        REQUIRE(pstl::transform_reduce(policy.with_grain_size(3), letters.begin(), letters.end(), ""s, std::plus{}, [](const auto &s) { return s; })
+            == "abcdefghijklmnopqrstuvwxyz");
+    }
+
+    SECTION("sort")
+    {
+        auto sorted = numbers;
+        pstl::sort(policy, sorted.begin(), sorted.end());
+
+        auto expected = numbers;
+        std::sort(expected.begin(), expected.end());
+        REQUIRE(sorted == expected);
+
+        WorkStealingPool pinned{4, Affinity::pinned};
+        pstl::sort(pstl::PoolPolicy{pinned, 100}, sorted.begin(), sorted.end(), std::greater{});
+        REQUIRE(std::is_sorted(sorted.begin(), sorted.end(), std::greater{}));
+
+        std::vector<int> same(50'000, 7);
+        pstl::sort(policy, same.begin(), same.end());
+        REQUIRE(std::all_of(same.begin(), same.end(), [](int n) { return n == 7; }));
+    }
+
+    SECTION("partition")
+    {
+        auto partitioned = numbers;
+        const auto middle = pstl::partition(policy, partitioned.begin(), partitioned.end(), [](int n) { return n % 3 == 0; });
+
+        auto expected = numbers;
+        std::stable_partition(expected.begin(), expected.end(), [](int n) { return n % 3 == 0; });
+        REQUIRE(partitioned == expected);
+        REQUIRE(middle - partitioned.begin() == std::count_if(numbers.begin(), numbers.end(), [](int n) { return n % 3 == 0; }));
+    }
+}
+
+TEST_CASE("DocumentArena")
+{
+    const std::vector<std::string> words{"short", "a word longer than the small string buffer", "x", "another long word to allocate"};
+
+    SECTION("CountingResource")
+    {
+        CountingResource counting{std::pmr::new_delete_resource()};
+        {
+            std::pmr::vector<int> numbers{&counting};
+            numbers.resize(100);
+            REQUIRE(counting.counts().allocations == 1);
+            REQUIRE(counting.counts().bytes == 100 * sizeof(int));
+        }
+        REQUIRE(counting.counts().deallocations == 1);
+
+        counting.reset_counts();
+        REQUIRE(counting.counts().allocations == 0);
+    }
+
+    for (const auto kind : {ArenaKind::none, ArenaKind::monotonic, ArenaKind::pool})
+    {
+        DocumentArena arena{kind};
+        {
+            auto copy = arena.copy(words.begin(), words.end());
+            REQUIRE(std::equal(copy.begin(), copy.end(), words.begin(), words.end(), [](const auto &a, const auto &b) { return std::string_view{a} == b; }));
+            REQUIRE(copy.get_allocator().resource() == arena.resource());
+            REQUIRE(copy[1].get_allocator().resource() == arena.resource());
+
+            std::sort(std::execution::par, copy.begin(), copy.end());
+            REQUIRE(std::is_sorted(copy.begin(), copy.end()));
+        }
+        REQUIRE(arena.requests().allocations == 3); // the vector and the two long words
+        REQUIRE(arena.requests().deallocations == 3);
+
+        arena.reset();
+        REQUIRE(arena.requests().allocations == 0);
+        REQUIRE(arena.upstream().allocations == 0);
+    }
+
+    SECTION("monotonic arena grows its buffer on reset")
+    {
+        std::vector<std::string> many_words(10'000, std::string(100, 'w'));
+        DocumentArena arena{ArenaKind::monotonic};
+
+        arena.copy(many_words.begin(), many_words.end());
+        REQUIRE(arena.upstream().allocations > 0);
+
+        arena.reset();
+        arena.copy(many_words.begin(), many_words.end());
+        REQUIRE(arena.requests().allocations == 10'001);
+        REQUIRE(arena.upstream().allocations == 0);
+    }
+}
+
+TEST_CASE("blocked_stable_partition")
+{
+    std::vector<int> numbers(100'000);
+    std::mt19937 gen{7};
+    std::uniform_int_distribution<int> distribution{0, 1'000'000};
+    std::generate(numbers.begin(), numbers.end(), [&] { return distribution(gen); });
+
+    auto is_odd = [](int n) { return n % 2 == 1; };
+    auto expected = numbers;
+    const auto expected_middle = std::stable_partition(expected.begin(), expected.end(), is_odd) - expected.begin();
+
+    for (const size_t block_size : {1, 64, 100, 4096, 1'000'000})
+    {
+        auto partitioned = numbers;
+        const auto middle = blocked_stable_partition(std::execution::par, partitioned.begin(), partitioned.end(), is_odd, block_size);
+        REQUIRE(middle - partitioned.begin() == expected_middle);
+        REQUIRE(partitioned == expected);
+    }
+
+    auto partitioned = numbers;
+    REQUIRE(blocked_stable_partition(partitioned.begin(), partitioned.end(), is_odd) - partitioned.begin() == expected_middle);
+    REQUIRE(partitioned == expected);
+
+    std::vector<std::string> words{"b", "A", "c", "D", "e"};
+    blocked_stable_partition(std::execution::par, words.begin(), words.end(), [](const auto &w) { return std::isupper(w[0]); });
+    REQUIRE(words == std::vector<std::string>{"A", "D", "b", "c", "e"});
+
+    std::vector<int> empty;
+    REQUIRE(blocked_stable_partition(std::execution::par, empty.begin(), empty.end(), is_odd) == empty.end());
+}
+
+TEST_CASE("PerThread")
+{
+    SECTION("one slot per thread")
+    {
+        PerThread<long> sums;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 8; ++t)
+        {
+            threads.emplace_back([&sums] {
+                for (int i = 1; i <= 1000; ++i)
+                    sums.local() += i;
+            });
+        }
+        for (auto &thd : threads)
+            thd.join();
+
+        REQUIRE(sums.size() <= 8);
+        REQUIRE(sums.combine(0L, std::plus{}) == 8 * 500'500);
+    }
+
+    SECTION("slots do not share cache lines")
+    {
+        PerThread<int> counters{7};
+        int *main_counter = &counters.local();
+        int *other_counter = nullptr;
+        std::thread{[&] { other_counter = &counters.local(); }}.join();
+
+        REQUIRE(*main_counter == 7);
+        REQUIRE(reinterpret_cast<uintptr_t>(main_counter) % per_thread_slot_alignment == 0);
+        REQUIRE(reinterpret_cast<uintptr_t>(other_counter) % per_thread_slot_alignment == 0);
+        REQUIRE(main_counter != other_counter);
+
+        const auto main_address = reinterpret_cast<uintptr_t>(main_counter);
+        const auto other_address = reinterpret_cast<uintptr_t>(other_counter);
+        REQUIRE(std::max(main_address, other_address) - std::min(main_address, other_address) >= per_thread_slot_alignment);
+    }
+
+    SECTION("parallel algorithm")
+    {
+        std::vector<int> numbers(100'000);
+        std::iota(numbers.begin(), numbers.end(), 0);
+
+        PerThread<std::vector<int>, alignof(std::vector<int>)> evens;
+        std::for_each(std::execution::par, numbers.begin(), numbers.end(), [&](int n) {
+            if (n % 2 == 0)
+                evens.local().push_back(n);
+        });
+
+        std::vector<int> all_evens;
+        evens.for_each([&](const auto &part) { all_evens.insert(all_evens.end(), part.begin(), part.end()); });
+        std::sort(all_evens.begin(), all_evens.end());
+        REQUIRE(all_evens.size() == 50'000);
+        REQUIRE(all_evens.back() == 99'998);
+    }
+}
+
+TEST_CASE("bit helpers")
+{
+    REQUIRE(count_trailing_zeros(1) == 0);
+    REQUIRE(count_trailing_zeros(0b1000) == 3);
+    REQUIRE(count_trailing_zeros(uint64_t{1} << 63) == 63);
+
+    REQUIRE(count_ones(0) == 0);
+    REQUIRE(count_ones(0b1011) == 3);
+    REQUIRE(count_ones(~uint64_t{0}) == 64);
+}
+
+TEST_CASE("compact")
+{
+    std::vector<uint64_t> numbers(10'000);
+    std::mt19937_64 gen{3};
+    std::generate(numbers.begin(), numbers.end(), [&] { return gen() % 1000; });
+
+    auto is_small = [](uint64_t n) { return n < 300; };
+
+    for (const size_t size : {0, 1, 3, 63, 64, 65, 1000, 9999, 10'000})
+    {
+        for (const size_t block_size : {64, 256, 4096})
+        {
+            std::vector<uint64_t> expected_of_size;
+            std::copy_if(numbers.begin(), numbers.begin() + size, std::back_inserter(expected_of_size), is_small);
+
+            std::vector<uint64_t> compacted(size, 12345);
+            const auto end = compact(std::execution::par, numbers.begin(), numbers.begin() + size, compacted.begin(), is_small, block_size);
+            REQUIRE(std::equal(compacted.begin(), end, expected_of_size.begin(), expected_of_size.end()));
+
+            std::vector<uint64_t> compacted_simd(size, 12345);
+            const auto end_simd = compact_simd(std::execution::par, numbers.data(), numbers.data() + size, compacted_simd.data(), is_small, block_size);
+            REQUIRE(std::equal(compacted_simd.data(), end_simd, expected_of_size.begin(), expected_of_size.end()));
+            REQUIRE(std::all_of(end_simd, compacted_simd.data() + size, [](uint64_t n) { return n == 12345; }));
+        }
+    }
+
+    SECTION("all and none selected")
+    {
+        std::vector<uint64_t> compacted(numbers.size());
+        REQUIRE(compact_simd(std::execution::par, numbers.data(), numbers.data() + numbers.size(), compacted.data(), [](uint64_t) { return true; })
+            == compacted.data() + numbers.size());
+        REQUIRE(compacted == numbers);
+        REQUIRE(compact_simd(std::execution::par, numbers.data(), numbers.data() + numbers.size(), compacted.data(), [](uint64_t) { return false; })
+            == compacted.data());
+    }
+
+    SECTION("sequenced, other types")
+    {
+        const std::vector<std::string> words{"a", "bb", "ccc", "dd", "e"};
+        std::vector<std::string> long_words(words.size());
+        long_words.resize(compact(words.begin(), words.end(), long_words.begin(), [](const auto &w) { return w.size() > 1; }) - long_words.begin());
+        REQUIRE(long_words == std::vector<std::string>{"bb", "ccc", "dd"});
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Functions run at the start of every thread the work-stealing pool and the pipeline create, so
+// tools that follow threads (the hardware counters) see those threads like the TBB workers
+class ThreadStartHooks
+{
+public:
+    static void add(std::function<void()> hook)
+    {
+        ThreadStartHooks &hooks = instance();
+        std::lock_guard lock{hooks.mtx_};
+        hooks.hooks_.push_back(std::move(hook));
+    }
+
+    static void run()
+    {
+        ThreadStartHooks &hooks = instance();
+        std::vector<std::function<void()>> hooks_to_run;
+        {
+            std::lock_guard lock{hooks.mtx_};
+            hooks_to_run = hooks.hooks_;
+        }
+
+        for (const auto &hook : hooks_to_run)
+            hook();
+    }
+
+private:
+    // Never destroyed - workers of static pools start and stop around the statics of other units
+    static ThreadStartHooks &instance()
+    {
+        static auto *hooks = new ThreadStartHooks;
+        return *hooks;
+    }
+
+    std::mutex mtx_;
+    std::vector<std::function<void()>> hooks_;
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <execution>
+#include <iterator>
+#include <numeric>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Same separators as operator>> with the classic locale
+constexpr bool is_space(char c) noexcept
+{
+    switch (c)
+    {
+    case ' ':
+    case '\t':
+    case '\n':
+    case '\v':
+    case '\f':
+    case '\r':
+        return true;
+    default:
+        return false;
+    }
+}
+
+template <typename OutputIterator>
+OutputIterator tokenize(std::string_view text, OutputIterator out)
+{
+    const char *it = text.data();
+    const char *const end = text.data() + text.size();
+
+    while (true)
+    {
+        while (it != end && is_space(*it))
+            ++it;
+
+        if (it == end)
+            return out;
+
+        const char *token_begin = it;
+        while (it != end && !is_space(*it))
+            ++it;
+
+        *out++ = std::string_view(token_begin, it - token_begin);
+    }
+}
+
+inline std::vector<std::string_view> tokenize(std::string_view text)
+{
+    std::vector<std::string_view> tokens;
+    tokenize(text, std::back_inserter(tokens));
+    return tokens;
+}
+
+// Splits text into whitespace-aligned chunks, tokenizes the chunks with the policy
+// and stitches the tokens back in the original order
+template <typename ExecutionPolicy, typename = std::enable_if_t<std::is_execution_policy_v<std::decay_t<ExecutionPolicy>>>>
+std::vector<std::string_view> tokenize(ExecutionPolicy &&policy, std::string_view text, size_t chunk_size = 64 * 1024)
+{
+    std::vector<std::string_view> chunks;
+    for (size_t chunk_begin = 0; chunk_begin < text.size();)
+    {
+        size_t chunk_end = std::min(chunk_begin + std::max<size_t>(chunk_size, 1), text.size());
+        while (chunk_end < text.size() && !is_space(text[chunk_end]))
+            ++chunk_end;
+
+        chunks.push_back(text.substr(chunk_begin, chunk_end - chunk_begin));
+        chunk_begin = chunk_end;
+    }
+
+    std::vector<std::vector<std::string_view>> chunk_tokens(chunks.size());
+    std::transform(policy, chunks.begin(), chunks.end(), chunk_tokens.begin(), [](std::string_view chunk) { return tokenize(chunk); });
+
+    std::vector<size_t> offsets(chunk_tokens.size());
+    std::transform_exclusive_scan(chunk_tokens.begin(), chunk_tokens.end(), offsets.begin(), size_t{0}, std::plus{}, [](const auto &tokens) { return tokens.size(); });
+
+    std::vector<std::string_view> tokens(chunk_tokens.empty() ? 0 : offsets.back() + chunk_tokens.back().size());
+    std::vector<size_t> chunk_indexes(chunk_tokens.size());
+    std::iota(chunk_indexes.begin(), chunk_indexes.end(), size_t{0});
+    std::for_each(policy, chunk_indexes.begin(), chunk_indexes.end(), [&](size_t chunk) {
+        std::copy(chunk_tokens[chunk].begin(), chunk_tokens[chunk].end(), tokens.begin() + offsets[chunk]);
+    });
+
+    return tokens;
+}
@@ -0,0 +1,269 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Scoped tracing zones exported as Chrome trace JSON (chrome://tracing, Perfetto):
+//
+//     trace::Zone zone{"is_prime"};
+//
+// Every thread appends to its own buffer without locking - the registry mutex is taken
+// once per thread, on its first zone. Zones are recorded only after trace::enable(),
+// a disabled zone costs a relaxed atomic load.
+namespace trace
+{
+    namespace detail
+    {
+        struct Event
+        {
+            const char *name; // must outlive the export - string literals
+            uint64_t begin_ns;
+            uint64_t end_ns;
+        };
+
+        // Written by the owning thread only, the size is published with release
+        // so the exporter sees complete events
+        struct Chunk
+        {
+            static constexpr size_t capacity = 4096;
+
+            std::array<Event, capacity> events;
+            std::atomic<size_t> size{0};
+            std::atomic<Chunk *> next{nullptr};
+        };
+
+        class ThreadBuffer
+        {
+        public:
+            explicit ThreadBuffer(uint32_t thread_id)
+                : thread_id_{thread_id}
+            {
+            }
+
+            ThreadBuffer(const ThreadBuffer &) = delete;
+            ThreadBuffer &operator=(const ThreadBuffer &) = delete;
+
+            ~ThreadBuffer()
+            {
+                release_chunks();
+            }
+
+            uint32_t thread_id() const noexcept
+            {
+                return thread_id_;
+            }
+
+            void append(const Event &event)
+            {
+                size_t size = tail_->size.load(std::memory_order_relaxed);
+                if (size == Chunk::capacity)
+                {
+                    Chunk *chunk = new Chunk;
+                    tail_->next.store(chunk, std::memory_order_release);
+                    tail_ = chunk;
+                    size = 0;
+                }
+
+                tail_->events[size] = event;
+                tail_->size.store(size + 1, std::memory_order_release);
+            }
+
+            template <typename Function>
+            void for_each_event(Function f) const
+            {
+                for (const Chunk *chunk = &head_; chunk; chunk = chunk->next.load(std::memory_order_acquire))
+                {
+                    const size_t size = chunk->size.load(std::memory_order_acquire);
+                    for (size_t i = 0; i < size; ++i)
+                        f(chunk->events[i]);
+                }
+            }
+
+            // Only while the owning thread is outside of any zone
+            void clear()
+            {
+                release_chunks();
+                head_.size.store(0, std::memory_order_relaxed);
+                tail_ = &head_;
+            }
+
+        private:
+            void release_chunks()
+            {
+                Chunk *chunk = head_.next.exchange(nullptr);
+                while (chunk)
+                {
+                    Chunk *next = chunk->next.load();
+                    delete chunk;
+                    chunk = next;
+                }
+            }
+
+            uint32_t thread_id_;
+            Chunk head_;
+            Chunk *tail_ = &head_;
+        };
+
+        inline std::atomic<bool> enabled{false};
+
+        inline uint64_t now_ns() noexcept
+        {
+            static const auto epoch = std::chrono::steady_clock::now();
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+        }
+
+        // Owns the buffers of all threads that ever recorded a zone - they outlive
+        // the threads, so the trace can be exported after the TBB workers are gone
+        class Registry
+        {
+        public:
+            static Registry &instance()
+            {
+                static Registry registry;
+                return registry;
+            }
+
+            ThreadBuffer &current_thread_buffer()
+            {
+                thread_local ThreadBuffer *buffer = nullptr;
+                if (!buffer)
+                {
+                    std::lock_guard lock{mtx_};
+                    buffers_.push_back(std::make_unique<ThreadBuffer>(static_cast<uint32_t>(buffers_.size() + 1)));
+                    buffer = buffers_.back().get();
+                }
+                return *buffer;
+            }
+
+            template <typename Function>
+            void for_each_buffer(Function f)
+            {
+                std::lock_guard lock{mtx_};
+                for (const auto &buffer : buffers_)
+                    f(*buffer);
+            }
+
+        private:
+            Registry() = default;
+
+            std::mutex mtx_;
+            std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+        };
+
+        inline void write_json_string(std::ostream &out, const char *text)
+        {
+            out << '"';
+            for (; *text; ++text)
+            {
+                const char c = *text;
+                if (c == '"' || c == '\\')
+                    out << '\\' << c;
+                else if (static_cast<unsigned char>(c) < 0x20)
+                    out << ' ';
+                else
+                    out << c;
+            }
+            out << '"';
+        }
+
+        // Chrome trace timestamps are microseconds - keeps the nanoseconds as decimals
+        inline void write_microseconds(std::ostream &out, uint64_t ns)
+        {
+            char buffer[32];
+            std::snprintf(buffer, sizeof(buffer), "%llu.%03llu", static_cast<unsigned long long>(ns / 1000), static_cast<unsigned long long>(ns % 1000));
+            out << buffer;
+        }
+    } // namespace detail
+
+    inline void enable() noexcept
+    {
+        detail::now_ns(); // starts the clock
+        detail::enabled.store(true, std::memory_order_relaxed);
+    }
+
+    inline void disable() noexcept
+    {
+        detail::enabled.store(false, std::memory_order_relaxed);
+    }
+
+    inline bool enabled() noexcept
+    {
+        return detail::enabled.load(std::memory_order_relaxed);
+    }
+
+    // Drops all recorded zones - only while no thread is inside a zone
+    inline void clear()
+    {
+        detail::Registry::instance().for_each_buffer([](detail::ThreadBuffer &buffer) { buffer.clear(); });
+    }
+
+    class Zone
+    {
+    public:
+        explicit Zone(const char *name) noexcept
+            : name_{name}
+        {
+            if (enabled())
+                begin_ns_ = detail::now_ns();
+        }
+
+        Zone(const Zone &) = delete;
+        Zone &operator=(const Zone &) = delete;
+
+        ~Zone()
+        {
+            if (begin_ns_ != not_recorded)
+                detail::Registry::instance().current_thread_buffer().append({name_, begin_ns_, detail::now_ns()});
+        }
+
+    private:
+        static constexpr uint64_t not_recorded = ~uint64_t{0};
+
+        const char *name_;
+        uint64_t begin_ns_ = not_recorded;
+    };
+
+    // Complete ("X") events of all threads, the thread that recorded first is named "main"
+    inline void write_chrome_trace(std::ostream &out)
+    {
+        out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+        out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"parallel-stl\"}}";
+
+        detail::Registry::instance().for_each_buffer([&](const detail::ThreadBuffer &buffer) {
+            const uint32_t tid = buffer.thread_id();
+            const std::string thread_name = tid == 1 ? "main" : "worker " + std::to_string(tid - 1);
+            out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid << ",\"args\":{\"name\":\"" << thread_name << "\"}}";
+
+            buffer.for_each_event([&](const detail::Event &event) {
+                out << ",\n{\"name\":";
+                detail::write_json_string(out, event.name);
+                out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid << ",\"ts\":";
+                detail::write_microseconds(out, event.begin_ns);
+                out << ",\"dur\":";
+                detail::write_microseconds(out, event.end_ns - event.begin_ns);
+                out << '}';
+            });
+        });
+
+        out << "\n]}\n";
+    }
+
+    inline bool write_chrome_trace(const std::string &file_name)
+    {
+        std::ofstream out{file_name};
+        if (!out)
+            return false;
+
+        write_chrome_trace(out);
+        return static_cast<bool>(out);
+    }
+} // namespace trace
@@ -0,0 +1,241 @@
+#pragma once
+
+#include "fast_hash.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <execution>
+#include <iterator>
+#include <numeric>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Open-addressing (linear probing) map from a word to its count - keys are views,
+// the counted text has to outlive the map
+class FrequencyMap
+{
+public:
+    struct Entry
+    {
+        std::string_view word;
+        uint64_t hash = 0;
+        uint64_t count = 0; // 0 - empty slot
+    };
+
+    explicit FrequencyMap(size_t expected_size = 0)
+    {
+        size_t capacity = 16;
+        while (capacity * 7 < expected_size * 10)
+            capacity *= 2;
+        slots_.resize(capacity);
+    }
+
+    void add(std::string_view word, uint64_t hash, uint64_t count = 1)
+    {
+        if ((size_ + 1) * 10 > slots_.size() * 7)
+            grow();
+
+        const size_t mask = slots_.size() - 1;
+        for (size_t i = hash & mask;; i = (i + 1) & mask)
+        {
+            Entry &slot = slots_[i];
+            if (slot.count == 0)
+            {
+                slot = Entry{word, hash, count};
+                ++size_;
+                return;
+            }
+            if (slot.hash == hash && slot.word == word)
+            {
+                slot.count += count;
+                return;
+            }
+        }
+    }
+
+    uint64_t count(std::string_view word, uint64_t hash) const noexcept
+    {
+        const size_t mask = slots_.size() - 1;
+        for (size_t i = hash & mask; slots_[i].count != 0; i = (i + 1) & mask)
+        {
+            if (slots_[i].hash == hash && slots_[i].word == word)
+                return slots_[i].count;
+        }
+        return 0;
+    }
+
+    size_t size() const noexcept
+    {
+        return size_;
+    }
+
+    template <typename Function>
+    void for_each(Function f) const
+    {
+        for (const auto &slot : slots_)
+        {
+            if (slot.count != 0)
+                f(slot);
+        }
+    }
+
+private:
+    void grow()
+    {
+        std::vector<Entry> old_slots(slots_.size() * 2);
+        old_slots.swap(slots_);
+        size_ = 0;
+
+        for (const auto &slot : old_slots)
+        {
+            if (slot.count != 0)
+                add(slot.word, slot.hash, slot.count);
+        }
+    }
+
+    std::vector<Entry> slots_;
+    size_t size_ = 0;
+};
+
+// Result of count_words - words are spread over shards by the high bits of their hash
+class WordFrequencies
+{
+public:
+    static constexpr int shard_bits = 6;
+    static constexpr size_t no_of_shards = size_t{1} << shard_bits;
+
+    static size_t shard_of(uint64_t hash) noexcept
+    {
+        return static_cast<size_t>(hash >> (64 - shard_bits));
+    }
+
+    uint64_t count(std::string_view word) const noexcept
+    {
+        const uint64_t hash = fast_hash(word);
+        return shards_[shard_of(hash)].count(word, hash);
+    }
+
+    size_t size() const noexcept
+    {
+        return std::accumulate(shards_.begin(), shards_.end(), size_t{0}, [](size_t total, const auto &shard) { return total + shard.size(); });
+    }
+
+    template <typename Function>
+    void for_each(Function f) const
+    {
+        for (const auto &shard : shards_)
+            shard.for_each([&](const FrequencyMap::Entry &entry) { f(entry.word, entry.count); });
+    }
+
+    // Sorted by descending count, ties by word
+    std::vector<std::pair<std::string_view, uint64_t>> most_frequent(size_t n) const
+    {
+        std::vector<std::pair<std::string_view, uint64_t>> result;
+        result.reserve(size());
+        for_each([&](std::string_view word, uint64_t count) { result.emplace_back(word, count); });
+
+        n = std::min(n, result.size());
+        std::partial_sort(result.begin(), result.begin() + n, result.end(), [](const auto &a, const auto &b) {
+            return a.second != b.second ? a.second > b.second : a.first < b.first;
+        });
+        result.resize(n);
+        return result;
+    }
+
+    std::array<FrequencyMap, no_of_shards> &shards() noexcept
+    {
+        return shards_;
+    }
+
+private:
+    std::array<FrequencyMap, no_of_shards> shards_;
+};
+
+namespace word_frequency_detail
+{
+    // Distinct words of one block, grouped by shard: the entries of shard s are
+    // entries[offsets[s]] ... entries[offsets[s + 1] - 1]
+    struct BlockCounts
+    {
+        std::vector<FrequencyMap::Entry> entries;
+        std::array<uint32_t, WordFrequencies::no_of_shards + 1> offsets{};
+    };
+
+    template <typename Iterator>
+    void count_block(Iterator first, Iterator last, BlockCounts &result)
+    {
+        const size_t size = std::distance(first, last);
+
+        std::vector<std::string_view> block_words;
+        block_words.reserve(size);
+        std::transform(first, last, std::back_inserter(block_words), [](const auto &word) { return std::string_view{word}; });
+
+        std::vector<uint64_t> hashes(size);
+        fast_hash(block_words.begin(), block_words.end(), hashes.begin());
+
+        FrequencyMap local_counts{size / 4};
+        for (size_t i = 0; i < size; ++i)
+            local_counts.add(block_words[i], hashes[i]);
+
+        std::array<uint32_t, WordFrequencies::no_of_shards> shard_sizes{};
+        local_counts.for_each([&](const FrequencyMap::Entry &entry) { ++shard_sizes[WordFrequencies::shard_of(entry.hash)]; });
+
+        result.offsets[0] = 0;
+        std::partial_sum(shard_sizes.begin(), shard_sizes.end(), result.offsets.begin() + 1);
+
+        auto positions = result.offsets;
+        result.entries.resize(local_counts.size());
+        local_counts.for_each([&](const FrequencyMap::Entry &entry) { result.entries[positions[WordFrequencies::shard_of(entry.hash)]++] = entry; });
+    }
+} // namespace word_frequency_detail
+
+// Counts words in two lock-free phases: every block of words is pre-aggregated into its own
+// small map (hot words collapse to one entry), then every shard merges its part of all blocks
+template <typename ExecutionPolicy, typename RandomAccessIterator,
+    typename = std::enable_if_t<std::is_execution_policy_v<std::decay_t<ExecutionPolicy>>>>
+WordFrequencies count_words(ExecutionPolicy &&policy, RandomAccessIterator first, RandomAccessIterator last, size_t block_size = 16 * 1024)
+{
+    using namespace word_frequency_detail;
+
+    const size_t size = std::distance(first, last);
+    const size_t no_of_blocks = std::max<size_t>(1, (size + block_size - 1) / block_size);
+
+    std::vector<BlockCounts> blocks(no_of_blocks);
+    std::vector<size_t> indexes(no_of_blocks);
+    std::iota(indexes.begin(), indexes.end(), size_t{0});
+
+    std::for_each(policy, indexes.begin(), indexes.end(), [&](size_t block) {
+        const size_t block_first = std::min(size, block * block_size);
+        const size_t block_last = std::min(size, block_first + block_size);
+        count_block(first + block_first, first + block_last, blocks[block]);
+    });
+
+    WordFrequencies frequencies;
+    std::vector<size_t> shard_indexes(WordFrequencies::no_of_shards);
+    std::iota(shard_indexes.begin(), shard_indexes.end(), size_t{0});
+
+    std::for_each(policy, shard_indexes.begin(), shard_indexes.end(), [&](size_t shard) {
+        size_t expected_size = 0;
+        for (const auto &block : blocks)
+            expected_size = std::max<size_t>(expected_size, block.offsets[shard + 1] - block.offsets[shard]);
+
+        FrequencyMap shard_counts{expected_size};
+        for (const auto &block : blocks)
+        {
+            for (uint32_t i = block.offsets[shard]; i < block.offsets[shard + 1]; ++i)
+                shard_counts.add(block.entries[i].word, block.entries[i].hash, block.entries[i].count);
+        }
+        frequencies.shards()[shard] = std::move(shard_counts);
+    });
+
+    return frequencies;
+}
+
+template <typename RandomAccessIterator>
+WordFrequencies count_words(RandomAccessIterator first, RandomAccessIterator last)
+{
+    return count_words(std::execution::seq, first, last);
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "ascii_case.hpp"
+#include "loser_tree.hpp"
+#include "pipeline.hpp"
+#include "tokenizer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+struct WordPipelineSettings
+{
+    size_t chunk_bytes = 64 * 1024;
+    size_t queue_capacity = 8; // chunks between two stages
+    size_t normalize_threads = std::max(1u, std::thread::hardware_concurrency() / 2);
+    size_t sort_threads = std::max(1u, std::thread::hardware_concurrency() / 2);
+};
+
+// Lower-cased words of one chunk of the input, sorted - views into the owned text,
+// which stays in place when the run is moved
+struct SortedRun
+{
+    std::unique_ptr<const std::string> text;
+    std::vector<std::string_view> words;
+};
+
+struct WordPipelineResult
+{
+    std::vector<SortedRun> runs; // in the order of completion
+    std::chrono::nanoseconds time_to_first_run{};
+    std::chrono::nanoseconds total_time{};
+};
+
+// load -> normalize -> sort as a streaming pipeline: while a chunk of the file is read,
+// earlier chunks are lower-cased and sorted into runs on the stages' own threads
+inline std::optional<WordPipelineResult> sort_runs_pipelined(const std::string &file_name, const WordPipelineSettings &settings = {})
+{
+    std::ifstream input_file{file_name, std::ios::binary};
+    if (!input_file)
+        return std::nullopt;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    BoundedQueue<std::string> chunks{settings.queue_capacity};
+    BoundedQueue<std::string> normalized_chunks{settings.queue_capacity};
+    BoundedQueue<SortedRun> runs{settings.queue_capacity};
+
+    WordPipelineResult result;
+    std::mutex mtx_result;
+
+    Pipeline pipeline;
+
+    pipeline.add_source(chunks, [&](auto emit) {
+        std::string carried;
+        std::vector<char> buffer(settings.chunk_bytes);
+
+        while (input_file)
+        {
+            input_file.read(buffer.data(), buffer.size());
+            std::string chunk = std::move(carried);
+            chunk.append(buffer.data(), static_cast<size_t>(input_file.gcount()));
+
+            // a word cut at the end of the chunk goes to the next one
+            size_t chunk_end = chunk.size();
+            if (input_file)
+            {
+                while (chunk_end > 0 && !is_space(chunk[chunk_end - 1]))
+                    --chunk_end;
+            }
+            carried = chunk.substr(chunk_end);
+            chunk.resize(chunk_end);
+
+            if (!chunk.empty() && !emit(std::move(chunk)))
+                return;
+        }
+    });
+
+    pipeline.add_stage(chunks, normalized_chunks, settings.normalize_threads, [](std::string chunk) {
+        to_lower_fast(chunk);
+        return chunk;
+    });
+
+    pipeline.add_stage(normalized_chunks, runs, settings.sort_threads, [](std::string chunk) {
+        SortedRun run{std::make_unique<const std::string>(std::move(chunk)), {}};
+        tokenize(*run.text, std::back_inserter(run.words));
+        std::sort(run.words.begin(), run.words.end());
+        return run;
+    });
+
+    pipeline.add_sink(runs, 1, [&](SortedRun run) {
+        std::lock_guard lock{mtx_result};
+        if (result.runs.empty())
+            result.time_to_first_run = std::chrono::steady_clock::now() - start;
+        result.runs.push_back(std::move(run));
+    });
+
+    pipeline.wait();
+    result.total_time = std::chrono::steady_clock::now() - start;
+
+    return result;
+}
+
+// k-way merge of the runs into one sorted sequence of views
+inline std::vector<std::string_view> merge_sorted_runs(const std::vector<SortedRun> &runs)
+{
+    size_t no_of_words = 0;
+    std::vector<std::optional<std::string_view>> heads;
+    for (const auto &run : runs)
+    {
+        no_of_words += run.words.size();
+        heads.push_back(run.words.empty() ? std::nullopt : std::optional{run.words.front()});
+    }
+
+    std::vector<size_t> positions(runs.size(), 0);
+    std::vector<std::string_view> merged;
+    merged.reserve(no_of_words);
+
+    LoserTree<std::string_view> tree{std::move(heads)};
+    while (!tree.empty())
+    {
+        const size_t source = tree.top_source();
+        merged.push_back(tree.top());
+
+        const auto &words = runs[source].words;
+        tree.replace_top(++positions[source] < words.size() ? std::optional{words[positions[source]]} : std::nullopt);
+    }
+
+    return merged;
+}
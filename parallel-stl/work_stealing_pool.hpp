@@ -0,0 +1,274 @@
+#pragma once
+
+#include "thread_hooks.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#define PSTL_HAS_THREAD_AFFINITY 1
+#endif
+
+enum class Affinity
+{
+    none,  // workers run wherever the OS schedules them
+    pinned // worker i is bound to the i-th CPU the process may use
+};
+
+// Fixed set of workers, each with its own task deque: a worker pushes and pops at the back of
+// its deque (LIFO - the freshest, cache-warm work), idle workers steal from the front of the others.
+// The affinity is fixed for the lifetime of the pool - pinned workers bind themselves when they start.
+class WorkStealingPool
+{
+public:
+    using Task = std::function<void()>;
+
+    explicit WorkStealingPool(size_t no_of_threads = std::max(1u, std::thread::hardware_concurrency()), Affinity affinity = Affinity::none)
+        : affinity_{affinity}
+    {
+        no_of_threads = std::max<size_t>(no_of_threads, 1);
+
+#ifdef PSTL_HAS_THREAD_AFFINITY
+        CPU_ZERO(&allowed_cpus_);
+        sched_getaffinity(0, sizeof(allowed_cpus_), &allowed_cpus_);
+#endif
+
+        for (size_t i = 0; i < no_of_threads; ++i)
+            workers_.push_back(std::make_unique<Worker>());
+
+        for (size_t i = 0; i < no_of_threads; ++i)
+            threads_.emplace_back([this, i] { worker_loop(i); });
+    }
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    ~WorkStealingPool()
+    {
+        {
+            std::lock_guard lock{mtx_sleep_};
+            stop_ = true;
+        }
+        cv_work_.notify_all();
+
+        for (auto &thd : threads_)
+            thd.join();
+    }
+
+    size_t size() const noexcept
+    {
+        return threads_.size();
+    }
+
+    // From a worker of this pool the task goes to its own deque, otherwise the deques take turns
+    void submit(Task task)
+    {
+        // counted before it can be taken, so a thief never decrements below zero
+        ++pending_;
+
+        const size_t index = current_pool_ == this ? current_index_ : next_queue_++ % workers_.size();
+        {
+            std::lock_guard lock{workers_[index]->mtx};
+            workers_[index]->tasks.push_back(std::move(task));
+        }
+
+        {
+            std::lock_guard lock{mtx_sleep_};
+        }
+        cv_work_.notify_one();
+    }
+
+    // Runs one pending task on the calling thread - lets a thread waiting for tasks help instead of blocking
+    bool try_run_one()
+    {
+        Task task;
+        const bool is_worker = current_pool_ == this;
+
+        if (is_worker)
+        {
+            Worker &own = *workers_[current_index_];
+            std::lock_guard lock{own.mtx};
+            if (!own.tasks.empty())
+            {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+            }
+        }
+
+        const size_t start = is_worker ? current_index_ + 1 : next_victim_++;
+        for (size_t i = 0; !task && i < workers_.size(); ++i)
+        {
+            Worker &victim = *workers_[(start + i) % workers_.size()];
+            std::lock_guard lock{victim.mtx};
+            if (!victim.tasks.empty())
+            {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+            }
+        }
+
+        if (!task)
+            return false;
+
+        --pending_;
+        task();
+        return true;
+    }
+
+    Affinity affinity() const noexcept
+    {
+        return affinity_;
+    }
+
+private:
+    struct Worker
+    {
+        std::mutex mtx;
+        std::deque<Task> tasks;
+    };
+
+    // Binds the calling worker to the index-th CPU the process may use
+    void pin_current_thread(size_t index) const
+    {
+#ifdef PSTL_HAS_THREAD_AFFINITY
+        std::vector<int> cpus;
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if (CPU_ISSET(cpu, &allowed_cpus_))
+                cpus.push_back(cpu);
+        }
+
+        if (cpus.empty())
+            return;
+
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(cpus[index % cpus.size()], &cpu_set);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+#else
+        (void)index;
+#endif
+    }
+
+    void worker_loop(size_t index)
+    {
+        current_pool_ = this;
+        current_index_ = index;
+
+        if (affinity_ == Affinity::pinned)
+            pin_current_thread(index);
+        ThreadStartHooks::run();
+
+        while (true)
+        {
+            if (try_run_one())
+                continue;
+
+            std::unique_lock lock{mtx_sleep_};
+            cv_work_.wait(lock, [this] { return stop_ || pending_ > 0; });
+            if (stop_ && pending_ == 0)
+                return;
+        }
+    }
+
+    inline static thread_local WorkStealingPool *current_pool_ = nullptr;
+    inline static thread_local size_t current_index_ = 0;
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+    std::atomic<size_t> pending_{0};
+    std::atomic<size_t> next_queue_{0};
+    std::atomic<size_t> next_victim_{0};
+    std::mutex mtx_sleep_;
+    std::condition_variable cv_work_;
+    bool stop_ = false;
+
+    const Affinity affinity_;
+#ifdef PSTL_HAS_THREAD_AFFINITY
+    cpu_set_t allowed_cpus_;
+#endif
+};
+
+// Fork-join on a pool: wait() runs pending tasks until all tasks of the group finished,
+// so groups can be nested inside tasks without blocking workers. The first exception is rethrown.
+class TaskGroup
+{
+public:
+    explicit TaskGroup(WorkStealingPool &pool)
+        : pool_{pool}
+    {
+    }
+
+    TaskGroup(const TaskGroup &) = delete;
+    TaskGroup &operator=(const TaskGroup &) = delete;
+
+    ~TaskGroup()
+    {
+        while (pending_ > 0)
+        {
+            if (!pool_.try_run_one())
+                std::this_thread::yield();
+        }
+    }
+
+    template <typename Function>
+    void run(Function function)
+    {
+        ++pending_;
+        pool_.submit([this, function = std::move(function)]() mutable {
+            try
+            {
+                function();
+            }
+            catch (...)
+            {
+                std::lock_guard lock{mtx_error_};
+                if (!error_)
+                    error_ = std::current_exception();
+            }
+            --pending_;
+        });
+    }
+
+    void wait()
+    {
+        while (pending_ > 0)
+        {
+            if (!pool_.try_run_one())
+                std::this_thread::yield();
+        }
+
+        if (error_)
+            std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+
+private:
+    WorkStealingPool &pool_;
+    std::atomic<size_t> pending_{0};
+    std::mutex mtx_error_;
+    std::exception_ptr error_;
+};
+
+inline WorkStealingPool &default_pool()
+{
+    static WorkStealingPool pool;
+    return pool;
+}
+
+// default_pool() with every worker bound to a CPU of its own
+inline WorkStealingPool &pinned_pool()
+{
+    static WorkStealingPool pool{default_pool().size(), Affinity::pinned};
+    return pool;
+}
@@ -0,0 +1,284 @@
+#pragma once
+
+#include "mul_high.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <execution>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+struct CorpusSettings
+{
+    size_t vocabulary_size = 50'000; // distinct words - ZipfCorpus throws if 16 draws in a row find no new word
+    double exponent = 1.0; // word of rank r occurs with probability ~ 1 / r^exponent
+    uint64_t seed = 42;
+    double capitalized_fraction = 0.1;     // occurrences starting with an upper-case letter
+    std::vector<double> length_weights = { // index = word length, roughly the lengths of English text
+        0, 3.0, 17.0, 20.0, 16.0, 11.0, 9.0, 8.0, 6.0, 4.0, 3.0, 1.5, 0.8, 0.4, 0.2, 0.1};
+};
+
+namespace zipf_corpus_detail
+{
+    // Own generator and distributions - the std ones are implementation-defined,
+    // a seed has to produce the same corpus with every standard library
+    class SplitMix64
+    {
+    public:
+        explicit SplitMix64(uint64_t seed) noexcept
+            : state_{seed}
+        {
+        }
+
+        uint64_t operator()() noexcept
+        {
+            uint64_t z = (state_ += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        }
+
+        // Uniform in [0, 1)
+        double next_double() noexcept
+        {
+            return ((*this)() >> 11) * 0x1.0p-53;
+        }
+
+    private:
+        uint64_t state_;
+    };
+
+    // Walker's alias method - samples a discrete distribution in O(1)
+    class AliasTable
+    {
+    public:
+        explicit AliasTable(const std::vector<double> &weights)
+            : probabilities_(weights.size()), aliases_(weights.size())
+        {
+            const double total = std::accumulate(weights.begin(), weights.end(), 0.0);
+            if (weights.empty() || !(total > 0))
+                throw std::invalid_argument("AliasTable: weights must have a positive sum");
+
+            std::vector<double> scaled(weights.size());
+            std::vector<uint32_t> small, large;
+            for (size_t i = 0; i < weights.size(); ++i)
+            {
+                scaled[i] = weights[i] * weights.size() / total;
+                (scaled[i] < 1.0 ? small : large).push_back(static_cast<uint32_t>(i));
+            }
+
+            while (!small.empty() && !large.empty())
+            {
+                const uint32_t less = small.back();
+                small.pop_back();
+                const uint32_t more = large.back();
+
+                probabilities_[less] = scaled[less];
+                aliases_[less] = more;
+
+                scaled[more] -= 1.0 - scaled[less];
+                if (scaled[more] < 1.0)
+                {
+                    large.pop_back();
+                    small.push_back(more);
+                }
+            }
+
+            for (uint32_t i : large)
+                probabilities_[i] = 1.0;
+            for (uint32_t i : small) // rounding leftovers
+                probabilities_[i] = 1.0;
+        }
+
+        size_t operator()(SplitMix64 &rnd_gen) const noexcept
+        {
+            const size_t column = mul_high(rnd_gen(), probabilities_.size());
+            return rnd_gen.next_double() < probabilities_[column] ? column : aliases_[column];
+        }
+
+    private:
+        std::vector<double> probabilities_;
+        std::vector<uint32_t> aliases_;
+    };
+
+    inline const std::vector<double> &letter_weights()
+    {
+        static const std::vector<double> weights = {8.2, 1.5, 2.8, 4.3, 12.7, 2.2, 2.0, 6.1, 7.0, 0.15, 0.77, 4.0, 2.4,
+            6.7, 7.5, 1.9, 0.095, 6.0, 6.3, 9.1, 2.8, 0.98, 2.4, 0.15, 2.0, 0.074};
+        return weights;
+    }
+
+    // Independent stream of every block - the corpus does not depend on the number of threads
+    inline SplitMix64 block_generator(uint64_t seed, size_t block) noexcept
+    {
+        SplitMix64 mixer{seed ^ (0xD1B54A32D192ED03ULL * (block + 1))};
+        return SplitMix64{mixer()};
+    }
+} // namespace zipf_corpus_detail
+
+// Deterministic synthetic text: a vocabulary of random letter strings (lengths drawn from
+// length_weights) whose ranks follow a Zipf distribution - the same settings always give the same words
+class ZipfCorpus
+{
+public:
+    static constexpr size_t words_per_block = 64 * 1024;
+    static constexpr size_t bytes_per_block = 4 * 1024 * 1024;
+
+    explicit ZipfCorpus(CorpusSettings settings = {})
+        : settings_{std::move(settings)}, ranks_{zipf_weights(settings_)}
+    {
+        build_vocabulary();
+    }
+
+    const CorpusSettings &settings() const noexcept
+    {
+        return settings_;
+    }
+
+    // Ordered by rank - vocabulary()[0] is the most frequent word
+    const std::vector<std::string> &vocabulary() const noexcept
+    {
+        return vocabulary_;
+    }
+
+    template <typename ExecutionPolicy>
+    std::vector<std::string> generate_words(ExecutionPolicy &&policy, size_t no_of_words) const
+    {
+        std::vector<std::string> words(no_of_words);
+
+        std::vector<size_t> blocks((no_of_words + words_per_block - 1) / words_per_block);
+        std::iota(blocks.begin(), blocks.end(), size_t{0});
+
+        std::for_each(policy, blocks.begin(), blocks.end(), [&](size_t block) {
+            auto rnd_gen = zipf_corpus_detail::block_generator(settings_.seed, block);
+            const size_t last = std::min(no_of_words, (block + 1) * words_per_block);
+            for (size_t i = block * words_per_block; i < last; ++i)
+                append_word(rnd_gen, words[i]);
+        });
+
+        return words;
+    }
+
+    std::vector<std::string> generate_words(size_t no_of_words) const
+    {
+        return generate_words(std::execution::seq, no_of_words);
+    }
+
+    // Writes one word per line (like tokens.txt) until no_of_bytes are written - blocks are generated
+    // in parallel batches and written in order, so memory stays bounded for corpora of any size
+    template <typename ExecutionPolicy>
+    bool write_file(ExecutionPolicy &&policy, const std::string &file_name, uint64_t no_of_bytes, size_t blocks_per_batch = 16) const
+    {
+        std::ofstream output_file{file_name, std::ios::binary};
+        if (!output_file)
+            return false;
+
+        const uint64_t no_of_blocks = (no_of_bytes + bytes_per_block - 1) / bytes_per_block;
+        std::vector<std::string> batch(blocks_per_batch);
+        std::vector<size_t> indexes(blocks_per_batch);
+
+        for (uint64_t first_block = 0; first_block < no_of_blocks; first_block += blocks_per_batch)
+        {
+            const size_t batch_size = static_cast<size_t>(std::min<uint64_t>(blocks_per_batch, no_of_blocks - first_block));
+            std::iota(indexes.begin(), indexes.begin() + batch_size, size_t{0});
+
+            std::for_each(policy, indexes.begin(), indexes.begin() + batch_size, [&](size_t i) {
+                const uint64_t block = first_block + i;
+                const uint64_t block_bytes = std::min<uint64_t>(bytes_per_block, no_of_bytes - block * bytes_per_block);
+                generate_text(block, static_cast<size_t>(block_bytes), batch[i]);
+            });
+
+            for (size_t i = 0; i < batch_size; ++i)
+                output_file.write(batch[i].data(), batch[i].size());
+
+            if (!output_file)
+                return false;
+        }
+
+        return true;
+    }
+
+    bool write_file(const std::string &file_name, uint64_t no_of_bytes) const
+    {
+        return write_file(std::execution::seq, file_name, no_of_bytes);
+    }
+
+private:
+    static std::vector<double> zipf_weights(const CorpusSettings &settings)
+    {
+        if (settings.vocabulary_size == 0)
+            throw std::invalid_argument("ZipfCorpus: empty vocabulary");
+
+        std::vector<double> weights(settings.vocabulary_size);
+        for (size_t rank = 0; rank < weights.size(); ++rank)
+            weights[rank] = 1.0 / std::pow(static_cast<double>(rank + 1), settings.exponent);
+        return weights;
+    }
+
+    void build_vocabulary()
+    {
+        const zipf_corpus_detail::AliasTable lengths{settings_.length_weights};
+        const zipf_corpus_detail::AliasTable letters{zipf_corpus_detail::letter_weights()};
+        zipf_corpus_detail::SplitMix64 rnd_gen{settings_.seed};
+
+        vocabulary_.reserve(settings_.vocabulary_size);
+        std::unordered_set<std::string> used;
+
+        while (vocabulary_.size() < settings_.vocabulary_size)
+        {
+            std::string word;
+            for (int attempt = 0; attempt < 16 && (word.empty() || used.count(word)); ++attempt)
+            {
+                word.assign(std::max<size_t>(1, lengths(rnd_gen)), ' ');
+                for (char &c : word)
+                    c = static_cast<char>('a' + letters(rnd_gen));
+            }
+
+            if (used.count(word))
+                throw std::invalid_argument("ZipfCorpus: the word lengths leave no room for vocabulary_size distinct words");
+
+            used.insert(word);
+            vocabulary_.push_back(std::move(word));
+        }
+    }
+
+    void append_word(zipf_corpus_detail::SplitMix64 &rnd_gen, std::string &word) const
+    {
+        const std::string &base = vocabulary_[ranks_(rnd_gen)];
+        const size_t offset = word.size();
+        word += base;
+        if (rnd_gen.next_double() < settings_.capitalized_fraction)
+            word[offset] = static_cast<char>(word[offset] - 'a' + 'A');
+    }
+
+    void generate_text(uint64_t block, size_t no_of_bytes, std::string &text) const
+    {
+        auto rnd_gen = zipf_corpus_detail::block_generator(settings_.seed, static_cast<size_t>(block));
+
+        text.clear();
+        text.reserve(no_of_bytes + 64);
+        while (true)
+        {
+            const size_t word_start = text.size();
+            append_word(rnd_gen, text);
+            text += '\n';
+
+            // only whole words of the vocabulary - line breaks fill the block up to its size
+            if (text.size() > no_of_bytes)
+            {
+                text.resize(word_start);
+                text.resize(no_of_bytes, '\n');
+                return;
+            }
+        }
+    }
+
+    CorpusSettings settings_;
+    zipf_corpus_detail::AliasTable ranks_;
+    std::vector<std::string> vocabulary_;
+};